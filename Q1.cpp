@@ -1,324 +1,1795 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <stdexcept>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
 using namespace std;
 
-string stripLeadingZeros(string s)
+typedef unsigned long long u64;
+typedef unsigned __int128 u128;
+
+// ---------- BigInt (base 2^64 limbs) ----------
+// Limbs are little-endian (d[0] is least significant) and never carry
+// leading zero limbs, so zero is the empty vector.
+struct BigInt
+{
+    vector<u64> d;
+
+    BigInt() {}
+    BigInt(u64 v)
+    {
+        if (v) d.push_back(v);
+    }
+
+    bool isZero() const { return d.empty(); }
+    int size() const { return d.size(); }
+
+    void trim()
+    {
+        while (!d.empty() && d.back() == 0)
+            d.pop_back();
+    }
+};
+
+int compareBig(const BigInt &a, const BigInt &b)
+{
+    if (a.size() != b.size())
+        return a.size() < b.size() ? -1 : 1;
+    for (int i = a.size() - 1; i >= 0; i--)
+    {
+        if (a.d[i] != b.d[i])
+            return a.d[i] < b.d[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+int bitLength(const BigInt &a)
+{
+    if (a.isZero()) return 0;
+    return (a.size() - 1) * 64 + (64 - __builtin_clzll(a.d.back()));
+}
+
+bool testBit(const BigInt &a, int k)
+{
+    int w = k / 64;
+    if (w >= a.size()) return false;
+    return (a.d[w] >> (k % 64)) & 1;
+}
+
+BigInt shiftLeftBits(const BigInt &a, int k)
+{
+    BigInt res;
+    if (a.isZero()) return res;
+    int w = k / 64, s = k % 64;
+    res.d.assign(a.size() + w + 1, 0);
+    for (int i = 0; i < a.size(); i++)
+    {
+        res.d[i + w] |= a.d[i] << s;
+        if (s) res.d[i + w + 1] = a.d[i] >> (64 - s);
+    }
+    res.trim();
+    return res;
+}
+
+BigInt shiftRightBits(const BigInt &a, int k)
+{
+    BigInt res;
+    int w = k / 64, s = k % 64;
+    if (w >= a.size()) return res;
+    res.d.resize(a.size() - w);
+    for (int i = 0; i < res.size(); i++)
+    {
+        res.d[i] = a.d[i + w] >> s;
+        if (s && i + w + 1 < a.size()) res.d[i] |= a.d[i + w + 1] << (64 - s);
+    }
+    res.trim();
+    return res;
+}
+
+// ---------- Limb kernels ----------
+// Raw little-endian limb arrays; the multiplication tiers work on these so
+// that one scratch buffer can be shared by the whole recursion.
+
+// The equal-length carry chains are the hot loop of every addition and
+// subtraction, so they come in two flavours: a portable scalar one and, on
+// x86-64 CPUs that report AVX2, a 4-limb-wide one. Both have the same
+// contract: r[0..n) = a[0..n) +/- b[0..n) + carry-in, returning the carry.
+u64 addChainScalar(u64 *r, const u64 *a, const u64 *b, int n, u64 carry)
+{
+    for (int i = 0; i < n; i++)
+    {
+        u128 s = (u128)a[i] + b[i] + carry;
+        r[i] = (u64)s;
+        carry = (u64)(s >> 64);
+    }
+    return carry;
+}
+
+u64 subChainScalar(u64 *r, const u64 *a, const u64 *b, int n, u64 borrow)
+{
+    for (int i = 0; i < n; i++)
+    {
+        u64 t = a[i] - b[i];
+        u64 nb = a[i] < b[i];
+        r[i] = t - borrow;
+        borrow = nb | (t < borrow);
+    }
+    return borrow;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// Four lanes at a time. Each lane either generates a carry (the lane sum
+// wrapped) or propagates an incoming one (the lane sum is all ones; the two
+// cases are exclusive). With g and p as 4-bit lane masks, the lanes that
+// receive a carry are ((g << 1 | cin) + p) ^ p, and bit 4 is the carry out,
+// so the whole block resolves with one scalar add instead of a serial
+// chain. Subtraction is the same with "a < b" as generate and "difference
+// is zero" as propagate.
+__attribute__((target("avx2"))) u64 addChainAvx2(u64 *r, const u64 *a, const u64 *b, int n, u64 carry)
+{
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    const __m256i lane = _mm256_setr_epi64x(0, 1, 2, 3);
+    const __m256i one = _mm256_set1_epi64x(1);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        __m256i s = _mm256_add_epi64(x, y);
+        // unsigned s < x through a signed compare with the sign bit flipped
+        __m256i gen = _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), _mm256_xor_si256(s, sign));
+        __m256i prop = _mm256_cmpeq_epi64(s, ones);
+        unsigned g = _mm256_movemask_pd(_mm256_castsi256_pd(gen));
+        unsigned p = _mm256_movemask_pd(_mm256_castsi256_pd(prop));
+        unsigned c = (((g << 1) | (unsigned)carry) + p) ^ p;
+        carry = c >> 4;
+        __m256i inc = _mm256_and_si256(_mm256_srlv_epi64(_mm256_set1_epi64x(c), lane), one);
+        _mm256_storeu_si256((__m256i *)(r + i), _mm256_add_epi64(s, inc));
+    }
+    return addChainScalar(r + i, a + i, b + i, n - i, carry);
+}
+
+__attribute__((target("avx2"))) u64 subChainAvx2(u64 *r, const u64 *a, const u64 *b, int n, u64 borrow)
 {
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lane = _mm256_setr_epi64x(0, 1, 2, 3);
+    const __m256i one = _mm256_set1_epi64x(1);
     int i = 0;
-    while (i < (int)s.length() - 1 && s[i] == '0')
-        i++;
-    return s.substr(i);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        __m256i t = _mm256_sub_epi64(x, y);
+        __m256i gen = _mm256_cmpgt_epi64(_mm256_xor_si256(y, sign), _mm256_xor_si256(x, sign));
+        __m256i prop = _mm256_cmpeq_epi64(t, zero);
+        unsigned g = _mm256_movemask_pd(_mm256_castsi256_pd(gen));
+        unsigned p = _mm256_movemask_pd(_mm256_castsi256_pd(prop));
+        unsigned c = (((g << 1) | (unsigned)borrow) + p) ^ p;
+        borrow = c >> 4;
+        __m256i dec = _mm256_and_si256(_mm256_srlv_epi64(_mm256_set1_epi64x(c), lane), one);
+        _mm256_storeu_si256((__m256i *)(r + i), _mm256_sub_epi64(t, dec));
+    }
+    return subChainScalar(r + i, a + i, b + i, n - i, borrow);
 }
+#endif
+
+typedef u64 (*ChainFn)(u64 *, const u64 *, const u64 *, int, u64);
+
+// Chains shorter than this stay scalar; the vector setup is not free.
+const int SIMD_CHAIN_MIN = 16;
 
-int compareStrings(const string &a, const string &b)
+bool cpuHasAvx2()
 {
-    string A = stripLeadingZeros(a);
-    string B = stripLeadingZeros(b);
-    if (A.length() < B.length())
-        return -1;
-    if (A.length() > B.length())
-        return 1;
-    for (int i = 0; i < (int)A.length(); i++)
+#if defined(__x86_64__) && defined(__GNUC__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+// Picked once at startup from the running CPU.
+#if defined(__x86_64__) && defined(__GNUC__)
+const ChainFn addChainWide = cpuHasAvx2() ? addChainAvx2 : addChainScalar;
+const ChainFn subChainWide = cpuHasAvx2() ? subChainAvx2 : subChainScalar;
+#else
+const ChainFn addChainWide = addChainScalar;
+const ChainFn subChainWide = subChainScalar;
+#endif
+
+// r[0..n) = a[0..n) + b[0..m) with m <= n; returns the carry out.
+u64 addLimbs(u64 *r, const u64 *a, int n, const u64 *b, int m)
+{
+    u64 carry = m < SIMD_CHAIN_MIN ? addChainScalar(r, a, b, m, 0) : addChainWide(r, a, b, m, 0);
+    for (int i = m; i < n; i++)
     {
-        if (A[i] < B[i]) return -1;
-        if (A[i] > B[i]) return 1;
+        u64 s = a[i] + carry;
+        carry = s < carry;
+        r[i] = s;
     }
-    return 0;
+    return carry;
 }
 
-// ---------- Addition ----------
-string addStrings(string a, string b)
+// r[0..n) = a[0..n) - b[0..m) with m <= n; returns the borrow out.
+u64 subLimbs(u64 *r, const u64 *a, int n, const u64 *b, int m)
 {
-    int i = a.length() - 1, j = b.length() - 1, carry = 0;
-    string res = "";
-    while (i >= 0 || j >= 0 || carry)
+    u64 borrow = m < SIMD_CHAIN_MIN ? subChainScalar(r, a, b, m, 0) : subChainWide(r, a, b, m, 0);
+    for (int i = m; i < n; i++)
     {
-        int da = (i >= 0) ? a[i--] - '0' : 0;
-        int db = (j >= 0) ? b[j--] - '0' : 0;
-        int sum = da + db + carry;
-        res = char('0' + (sum % 10)) + res;
-        carry = sum / 10;
+        u64 t = a[i] - borrow;
+        borrow = a[i] < borrow;
+        r[i] = t;
     }
-    return stripLeadingZeros(res);
+    return borrow;
 }
 
-// ---------- Subtraction (a >= b only, per spec) ----------
-string subtractStrings(string a, string b)
+// r[0..n+m) = a * b, schoolbook.
+void mulSchool(u64 *r, const u64 *a, int n, const u64 *b, int m)
 {
-    if (compareStrings(a, b) < 0) return "0"; // no negatives allowed
-    int i = a.length() - 1, j = b.length() - 1, borrow = 0;
-    string res = "";
-    while (i >= 0)
+    for (int i = 0; i < n + m; i++)
+        r[i] = 0;
+    for (int i = 0; i < m; i++)
     {
-        int da = a[i] - '0' - borrow;
-        int db = (j >= 0) ? b[j--] - '0' : 0;
-        if (da < db)
+        u64 carry = 0;
+        for (int j = 0; j < n; j++)
         {
-            da += 10;
-            borrow = 1;
+            u128 p = (u128)a[j] * b[i] + r[i + j] + carry;
+            r[i + j] = (u64)p;
+            carry = (u64)(p >> 64);
         }
-        else borrow = 0;
-        res = char('0' + (da - db)) + res;
-        i--;
+        r[i + n] = carry;
     }
-    return stripLeadingZeros(res);
+}
+
+BigInt fromLimbs(const u64 *p, int len)
+{
+    BigInt x;
+    x.d.assign(p, p + len);
+    x.trim();
+    return x;
+}
+
+// ---------- Addition ----------
+BigInt addBig(const BigInt &a, const BigInt &b)
+{
+    const BigInt &x = a.size() >= b.size() ? a : b;
+    const BigInt &y = a.size() >= b.size() ? b : a;
+    BigInt res;
+    res.d.resize(x.size() + 1);
+    res.d[x.size()] = addLimbs(res.d.data(), x.d.data(), x.size(), y.d.data(), y.size());
+    res.trim();
+    return res;
+}
+
+// acc += b, reusing acc's storage.
+void addTo(BigInt &acc, const BigInt &b)
+{
+    int n = max(acc.size(), b.size());
+    acc.d.resize(n + 1, 0);
+    acc.d[n] = addLimbs(acc.d.data(), acc.d.data(), n, b.d.data(), b.size());
+    acc.trim();
+}
+
+// ---------- Subtraction (a >= b only, per spec) ----------
+BigInt subBig(const BigInt &a, const BigInt &b)
+{
+    if (compareBig(a, b) < 0) return BigInt(); // no negatives allowed
+    BigInt res;
+    res.d.resize(a.size());
+    subLimbs(res.d.data(), a.d.data(), a.size(), b.d.data(), b.size());
+    res.trim();
+    return res;
+}
+
+// acc -= b in place; clamps to zero like subBig.
+void subFrom(BigInt &acc, const BigInt &b)
+{
+    if (compareBig(acc, b) < 0)
+    {
+        acc.d.clear();
+        return;
+    }
+    subLimbs(acc.d.data(), acc.d.data(), acc.size(), b.d.data(), b.size());
+    acc.trim();
 }
 
 // ---------- Multiplication ----------
-string multiplyStrings(string a, string b)
+// Tier thresholds in limbs of the shorter operand.
+const int KARATSUBA_THRESHOLD = 32;
+const int TOOM3_THRESHOLD = 256;
+const int NTT_THRESHOLD = 2048;
+
+void mulLimbs(u64 *r, const u64 *a, int n, const u64 *b, int m, u64 *ws);
+BigInt mulBig(const BigInt &a, const BigInt &b);
+
+BigInt mulSmall(const BigInt &a, u64 m)
+{
+    BigInt res;
+    if (a.isZero() || m == 0) return res;
+    res.d.resize(a.size() + 1);
+    u64 carry = 0;
+    for (int i = 0; i < a.size(); i++)
+    {
+        u128 p = (u128)a.d[i] * m + carry;
+        res.d[i] = (u64)p;
+        carry = (u64)(p >> 64);
+    }
+    res.d[a.size()] = carry;
+    res.trim();
+    return res;
+}
+
+BigInt shiftRight1(const BigInt &a)
+{
+    BigInt res = a;
+    for (int i = 0; i < res.size(); i++)
+        res.d[i] = (res.d[i] >> 1) | (i + 1 < res.size() ? res.d[i + 1] << 63 : 0);
+    res.trim();
+    return res;
+}
+
+// Exact division by 3 via the inverse of 3 mod 2^64 (a must be a multiple of 3).
+BigInt divExact3(const BigInt &a)
+{
+    const u64 INV3 = 0xAAAAAAAAAAAAAAABULL;
+    BigInt res;
+    res.d.resize(a.size());
+    u64 borrow = 0;
+    for (int i = 0; i < a.size(); i++)
+    {
+        u64 x = a.d[i] - borrow;
+        u64 b1 = a.d[i] < borrow;
+        u64 q = x * INV3;
+        res.d[i] = q;
+        borrow = (u64)(((u128)q * 3) >> 64) + b1;
+    }
+    res.trim();
+    return res;
+}
+
+// Sign-magnitude value for the Toom-3 evaluation points.
+struct SignedBig
+{
+    BigInt mag;
+    bool neg;
+};
+
+SignedBig signedAdd(const SignedBig &x, const SignedBig &y)
+{
+    if (x.neg == y.neg) return {addBig(x.mag, y.mag), x.neg};
+    if (compareBig(x.mag, y.mag) >= 0) return {subBig(x.mag, y.mag), x.neg};
+    return {subBig(y.mag, x.mag), y.neg};
+}
+
+SignedBig signedSub(const SignedBig &x, const SignedBig &y)
+{
+    return signedAdd(x, {y.mag, !y.neg});
+}
+
+SignedBig signedMul(const SignedBig &x, const SignedBig &y)
+{
+    return {mulBig(x.mag, y.mag), x.neg != y.neg};
+}
+
+// Values of a0 + a1 t + a2 t^2 at t = 0, 1, -1, -2 and infinity.
+void toom3Evaluate(const BigInt &a0, const BigInt &a1, const BigInt &a2, SignedBig v[5])
 {
-    a = stripLeadingZeros(a);
-    b = stripLeadingZeros(b);
-    if (a == "0" || b == "0") return "0";
-    int n = a.length(), m = b.length();
-    int res[6005] = {0};
-    for (int i = n - 1; i >= 0; i--)
+    BigInt t = addBig(a0, a2);
+    v[0] = {a0, false};
+    v[1] = {addBig(t, a1), false};
+    v[2] = signedSub({t, false}, {a1, false});
+    SignedBig s = signedAdd(v[2], {a2, false});
+    v[3] = signedSub({addBig(s.mag, s.mag), s.neg}, {a0, false});
+    v[4] = {a2, false};
+}
+
+// Balanced Toom-3 (Bodrato's interpolation sequence); needs m > 2 * ceil(n / 3).
+void mulToom3(u64 *r, const u64 *a, int n, const u64 *b, int m)
+{
+    int k = (n + 2) / 3;
+    SignedBig pa[5], pb[5], w[5];
+    toom3Evaluate(fromLimbs(a, k), fromLimbs(a + k, k), fromLimbs(a + 2 * k, n - 2 * k), pa);
+    toom3Evaluate(fromLimbs(b, k), fromLimbs(b + k, k), fromLimbs(b + 2 * k, m - 2 * k), pb);
+    for (int i = 0; i < 5; i++)
+        w[i] = signedMul(pa[i], pb[i]);
+
+    // w = r(0), r(1), r(-1), r(-2), r(inf)
+    SignedBig t3 = signedSub(w[3], w[1]);
+    t3.mag = divExact3(t3.mag);
+    SignedBig t1 = signedSub(w[1], w[2]);
+    t1.mag = shiftRight1(t1.mag);
+    SignedBig t2 = signedSub(w[2], w[0]);
+    t3 = signedSub(t2, t3);
+    t3.mag = shiftRight1(t3.mag);
+    t3 = signedAdd(t3, {addBig(w[4].mag, w[4].mag), false});
+    t2 = signedSub(signedAdd(t2, t1), w[4]);
+    t1 = signedSub(t1, t3);
+
+    const BigInt *coef[5] = {&w[0].mag, &t1.mag, &t2.mag, &t3.mag, &w[4].mag};
+    for (int i = 0; i < n + m; i++)
+        r[i] = 0;
+    for (int i = 0; i < 5; i++)
     {
-        for (int j = m - 1; j >= 0; j--)
+        int off = i * k;
+        addLimbs(r + off, r + off, n + m - off, coef[i]->d.data(), coef[i]->size());
+    }
+}
+
+// ---------- NTT multiplication ----------
+// Whole 64-bit limbs are convolved modulo three primes p = c * 2^50 + 1 just
+// above 2^61, using Montgomery arithmetic. A convolution coefficient is below
+// len * 2^128 < p1 * p2 * p3, so the CRT reconstruction is exact.
+const u64 NTT_P1 = 2308094809027379201ULL; // 2050 * 2^50 + 1
+const u64 NTT_P2 = 2375648803437936641ULL; // 2110 * 2^50 + 1
+const u64 NTT_P3 = 2406048100922687489ULL; // 2137 * 2^50 + 1
+const int NTT_MAX_LIMBS = 1 << 24;          // keeps the transform buffers bounded
+
+// Montgomery arithmetic modulo MOD < 2^62 with R = 2^64.
+template <u64 MOD>
+struct Mont
+{
+    static u64 inv() // -MOD^-1 mod 2^64
+    {
+        u64 x = MOD;
+        for (int i = 0; i < 6; i++)
+            x *= 2 - MOD * x;
+        return -x;
+    }
+
+    static u64 redc(u128 t)
+    {
+        static const u64 NINV = inv();
+        u64 m = (u64)t * NINV;
+        u64 r = (u64)((t + (u128)m * MOD) >> 64);
+        return r >= MOD ? r - MOD : r;
+    }
+
+    static u64 mul(u64 a, u64 b) { return redc((u128)a * b); }
+    static u64 add(u64 a, u64 b) { return a + b >= MOD ? a + b - MOD : a + b; }
+    static u64 sub(u64 a, u64 b) { return a >= b ? a - b : a + MOD - b; }
+
+    static u64 toMont(u64 a) // any a < 2^64
+    {
+        static const u64 R2 = (u64)(((u128)(-MOD % MOD) * (-MOD % MOD)) % MOD);
+        return mul(a, R2);
+    }
+
+    static u64 pow(u64 b, u64 e) // b and result in Montgomery form
+    {
+        u64 r = toMont(1);
+        while (e)
         {
-            int p = (a[i] - '0') * (b[j] - '0');
-            int sum = p + res[i + j + 1];
-            res[i + j + 1] = sum % 10;
-            res[i + j] += sum / 10;
+            if (e & 1) r = mul(r, b);
+            b = mul(b, b);
+            e >>= 1;
         }
+        return r;
+    }
+};
+
+// In-place forward NTT of Montgomery-form values (primitive root 3).
+template <u64 MOD>
+void ntt(vector<u64> &a)
+{
+    typedef Mont<MOD> M;
+    int n = a.size();
+    for (int i = 1, j = 0; i < n; i++)
+    {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j) swap(a[i], a[j]);
+    }
+
+    // rt[half + k] = w_len^k for each stage len = 2 * half
+    vector<u64> rt(max(n, 2));
+    rt[1] = M::toMont(1);
+    for (int half = 2; half < n; half <<= 1)
+    {
+        u64 w = M::pow(M::toMont(3), (MOD - 1) / (2 * half));
+        for (int k = 0; k < half; k++)
+            rt[half + k] = (k & 1) ? M::mul(rt[half + k - 1], w) : rt[(half + k) / 2];
+    }
+
+    for (int half = 1; half < n; half <<= 1)
+    {
+        for (int i = 0; i < n; i += 2 * half)
+        {
+            for (int k = 0; k < half; k++)
+            {
+                u64 u = a[i + k];
+                u64 v = M::mul(a[i + k + half], rt[half + k]);
+                a[i + k] = M::add(u, v);
+                a[i + k + half] = M::sub(u, v);
+            }
+        }
+    }
+}
+
+// Cyclic convolution of a and b modulo MOD, returned as plain residues.
+template <u64 MOD>
+void convolve(const u64 *a, int n, const u64 *b, int m, int len, vector<u64> &out)
+{
+    typedef Mont<MOD> M;
+    out.assign(len, 0);
+    for (int i = 0; i < n; i++)
+        out[i] = M::toMont(a[i]);
+    ntt<MOD>(out);
+    if (a == b && n == m)
+    {
+        for (int i = 0; i < len; i++)
+            out[i] = M::mul(out[i], out[i]);
+    }
+    else
+    {
+        vector<u64> fb(len, 0);
+        for (int i = 0; i < m; i++)
+            fb[i] = M::toMont(b[i]);
+        ntt<MOD>(fb);
+        for (int i = 0; i < len; i++)
+            out[i] = M::mul(out[i], fb[i]);
+    }
+
+    // inverse transform = forward transform, reverse out[1..len), scale by 1/len
+    ntt<MOD>(out);
+    reverse(out.begin() + 1, out.end());
+    u64 invLen = MOD - (MOD - 1) / len; // (1 - MOD) / len == 1 / len mod MOD
+    for (int i = 0; i < len; i++)
+        out[i] = M::mul(out[i], invLen);
+}
+
+// r[0..n+m) = a * b; needs n + m <= NTT_MAX_LIMBS.
+void mulNTT(u64 *r, const u64 *a, int n, const u64 *b, int m)
+{
+    int len = 1;
+    while (len < n + m)
+        len <<= 1;
+
+    vector<u64> c1, c2, c3;
+    convolve<NTT_P1>(a, n, b, m, len, c1);
+    convolve<NTT_P2>(a, n, b, m, len, c2);
+    convolve<NTT_P3>(a, n, b, m, len, c3);
+
+    // Garner: x = x1 + x2 * p1 + x3 * p1 * p2, where the inverses are kept in
+    // Montgomery form so that one mul() yields a plain residue.
+    typedef Mont<NTT_P2> M2;
+    typedef Mont<NTT_P3> M3;
+    const u64 inv1mod2 = M2::pow(M2::toMont(NTT_P1), NTT_P2 - 2);
+    const u64 inv1mod3 = M3::pow(M3::toMont(NTT_P1), NTT_P3 - 2);
+    const u64 inv2mod3 = M3::pow(M3::toMont(NTT_P2), NTT_P3 - 2);
+    const u128 p12 = (u128)NTT_P1 * NTT_P2;
+
+    u64 acc0 = 0, acc1 = 0, acc2 = 0; // 192-bit running carry
+    for (int i = 0; i < n + m; i++)
+    {
+        u64 x1 = c1[i];
+        u64 x2 = M2::mul(M2::sub(c2[i], x1 % NTT_P2), inv1mod2);
+        u64 x3 = M3::mul(M3::sub(c3[i], x1 % NTT_P3), inv1mod3);
+        x3 = M3::mul(M3::sub(x3, x2 % NTT_P3), inv2mod3);
+
+        u128 lo = (u128)x3 * (u64)p12;
+        u128 hi = (u128)x3 * (u64)(p12 >> 64);
+        u128 s = (u128)acc0 + x1 + (u64)lo;
+        acc0 = (u64)s;
+        s = (s >> 64) + (u128)acc1 + (u64)(lo >> 64) + (u64)hi;
+        acc1 = (u64)s;
+        acc2 += (u64)(s >> 64) + (u64)(hi >> 64);
+
+        u128 t = (u128)x2 * NTT_P1;
+        s = (u128)acc0 + (u64)t;
+        acc0 = (u64)s;
+        s = (s >> 64) + (u128)acc1 + (u64)(t >> 64);
+        acc1 = (u64)s;
+        acc2 += (u64)(s >> 64);
+
+        r[i] = acc0;
+        acc0 = acc1;
+        acc1 = acc2;
+        acc2 = 0;
     }
-    string s = "";
-    int i = 0;
-    while (i < n + m && res[i] == 0) i++;
-    for (; i < n + m; i++) s += char('0' + res[i]);
-    return s == "" ? "0" : s;
 }
 
-// ---------- Division (quotient only) ----------
-string divideStrings(string a, string b)
+// Karatsuba split at h = ceil(n / 2); needs m >= h.
+void mulKaratsuba(u64 *r, const u64 *a, int n, const u64 *b, int m, u64 *ws)
 {
-    a = stripLeadingZeros(a);
-    b = stripLeadingZeros(b);
-    if (b == "0") return "0";
-    if (compareStrings(a, b) < 0) return "0";
+    int h = (n + 1) / 2;
+    mulLimbs(r, a, h, b, h, ws);
+    mulLimbs(r + 2 * h, a + h, n - h, b + h, m - h, ws);
 
-    string result = "";
-    string cur = "";
-    for (int i = 0; i < (int)a.length(); i++)
+    u64 *sa = ws, *sb = ws + (h + 1), *z1 = ws + 2 * (h + 1);
+    sa[h] = addLimbs(sa, a, h, a + h, n - h);
+    sb[h] = addLimbs(sb, b, h, b + h, m - h);
+    mulLimbs(z1, sa, h + 1, sb, h + 1, ws + 4 * (h + 1));
+
+    // z1 = (a0 + a1)(b0 + b1) - z0 - z2, added in at offset h
+    int zn = 2 * (h + 1);
+    subLimbs(z1, z1, zn, r, 2 * h);
+    subLimbs(z1, z1, zn, r + 2 * h, n + m - 2 * h);
+    while (zn > 0 && z1[zn - 1] == 0)
+        zn--;
+    addLimbs(r + h, r + h, n + m - h, z1, zn);
+}
+
+// r[0..n+m) = a * b with n >= m, picking the tier by operand shape.
+void mulLimbs(u64 *r, const u64 *a, int n, const u64 *b, int m, u64 *ws)
+{
+    if (m < KARATSUBA_THRESHOLD)
+        mulSchool(r, a, n, b, m);
+    else if (m >= NTT_THRESHOLD && n + m <= NTT_MAX_LIMBS)
+        mulNTT(r, a, n, b, m);
+    else if (2 * m <= n)
     {
-        cur += a[i];
-        cur = stripLeadingZeros(cur);
-        int q = 0;
-        while (compareStrings(cur, b) >= 0)
+        // unbalanced: multiply b against m-limb blocks of a
+        for (int i = 0; i < n + m; i++)
+            r[i] = 0;
+        u64 *t = ws;
+        for (int i = 0; i < n; i += m)
         {
-            cur = subtractStrings(cur, b);
-            q++;
+            int len = min(m, n - i);
+            if (len == m) mulLimbs(t, a + i, len, b, m, ws + 2 * m);
+            else mulLimbs(t, b, m, a + i, len, ws + 2 * m);
+            addLimbs(r + i, r + i, n + m - i, t, len + m);
         }
-        result += char('0' + q);
     }
-    return stripLeadingZeros(result);
+    else if (m >= TOOM3_THRESHOLD && m > 2 * ((n + 2) / 3))
+        mulToom3(r, a, n, b, m);
+    else
+        mulKaratsuba(r, a, n, b, m, ws);
+}
+
+// Scratch limbs needed by mulLimbs for operands of n >= m limbs.
+int mulScratchSize(int n, int m)
+{
+    int s = 2 * m;
+    n = min(n, 2 * m);
+    while (n >= KARATSUBA_THRESHOLD)
+    {
+        int h = (n + 1) / 2;
+        s += 4 * (h + 1);
+        n = h + 1;
+    }
+    return s;
 }
 
-// ---------- Modulo ----------
-string modStrings(string a, string b)
+// r = a * b reusing r's storage and the caller's scratch buffer, which only
+// ever grows. r must not alias a or b. Only the Toom-3 and NTT tiers still
+// allocate internally.
+void mulInto(BigInt &r, const BigInt &a, const BigInt &b, vector<u64> &ws)
 {
-    a = stripLeadingZeros(a);
-    b = stripLeadingZeros(b);
-    if (b == "0") return "0";
-    if (compareStrings(a, b) < 0) return a;
+    if (a.isZero() || b.isZero())
+    {
+        r.d.clear();
+        return;
+    }
+    const BigInt &x = a.size() >= b.size() ? a : b;
+    const BigInt &y = a.size() >= b.size() ? b : a;
+    int n = x.size(), m = y.size();
+    r.d.resize(n + m);
+    int need = mulScratchSize(n, m);
+    if ((int)ws.size() < need) ws.resize(need);
+    mulLimbs(r.d.data(), x.d.data(), n, y.d.data(), m, ws.data());
+    r.trim();
+}
 
-    string cur = "";
-    for (int i = 0; i < (int)a.length(); i++)
+BigInt mulBig(const BigInt &a, const BigInt &b)
+{
+    BigInt res;
+    vector<u64> ws;
+    mulInto(res, a, b, ws);
+    return res;
+}
+
+// acc *= m in place.
+void mulSmallTo(BigInt &acc, u64 m)
+{
+    if (m == 0)
     {
-        cur += a[i];
-        cur = stripLeadingZeros(cur);   
-        while (compareStrings(cur, b) >= 0)
+        acc.d.clear();
+        return;
+    }
+    u64 carry = 0;
+    for (int i = 0; i < acc.size(); i++)
+    {
+        u128 p = (u128)acc.d[i] * m + carry;
+        acc.d[i] = (u64)p;
+        carry = (u64)(p >> 64);
+    }
+    if (carry) acc.d.push_back(carry);
+}
+
+// ---------- Division (quotient and remainder) ----------
+// Newton division is used once both the divisor and the quotient reach
+// NEWTON_DIV_THRESHOLD limbs; reciprocals below NEWTON_BASE_BITS come
+// straight from Algorithm D.
+const int NEWTON_DIV_THRESHOLD = 2048;
+const int NEWTON_BASE_BITS = 64 * 32;
+
+// Divides by a single limb, returning the remainder through rem.
+BigInt divmodSmall(const BigInt &a, u64 m, u64 &rem)
+{
+    BigInt q;
+    q.d.resize(a.size());
+    u128 r = 0;
+    for (int i = a.size() - 1; i >= 0; i--)
+    {
+        u128 cur = (r << 64) | a.d[i];
+        q.d[i] = (u64)(cur / m);
+        r = cur % m;
+    }
+    q.trim();
+    rem = (u64)r;
+    return q;
+}
+
+// Knuth's Algorithm D (TAOCP 4.3.1) for a divisor of at least two limbs.
+void divmodKnuth(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r)
+{
+    int n = a.size(), m = b.size();
+    int s = __builtin_clzll(b.d.back());
+    BigInt vn = shiftLeftBits(b, s);
+    vector<u64> un(n + 1, 0);
+    for (int i = 0; i < n; i++)
+    {
+        un[i] |= a.d[i] << s;
+        if (s) un[i + 1] = a.d[i] >> (64 - s);
+    }
+
+    const u128 B = (u128)1 << 64;
+    u64 vtop = vn.d[m - 1], vnext = vn.d[m - 2];
+    q.d.assign(n - m + 1, 0);
+    for (int j = n - m; j >= 0; j--)
+    {
+        // estimate qhat from the top two limbs, then refine with the third
+        u128 num = ((u128)un[j + m] << 64) | un[j + m - 1];
+        u128 qhat = num / vtop, rhat = num % vtop;
+        if (qhat >= B)
+        {
+            qhat = B - 1;
+            rhat = num - qhat * vtop;
+        }
+        while (rhat < B && qhat * vnext > ((rhat << 64) | un[j + m - 2]))
+        {
+            qhat--;
+            rhat += vtop;
+        }
+
+        // un[j..j+m] -= qhat * vn
+        u64 carry = 0, borrow = 0;
+        for (int i = 0; i <= m; i++)
+        {
+            u128 p = (u128)qhat * (i < m ? vn.d[i] : 0) + carry;
+            carry = (u64)(p >> 64);
+            u64 t = un[i + j] - (u64)p;
+            u64 nb = un[i + j] < (u64)p;
+            un[i + j] = t - borrow;
+            borrow = nb | (t < borrow);
+        }
+        if (borrow)
         {
-            cur = subtractStrings(cur, b);
+            // qhat was one too large: add the divisor back
+            qhat--;
+            un[j + m] += addLimbs(&un[j], &un[j], m, vn.d.data(), m);
         }
+        q.d[j] = (u64)qhat;
     }
-    return stripLeadingZeros(cur);
+    q.trim();
+
+    un.resize(m);
+    r.d = un;
+    r.trim();
+    r = shiftRightBits(r, s);
 }
 
-// ---------- GCD ----------
-string gcdStrings(string a, string b)
+// Approximates floor(2^(2p) / v) for a p-bit v by Newton's iteration
+// x' = x + x (2^(2p) - v x) / 2^(2p), doubling the precision each step.
+// The result is within a few units of the true value.
+BigInt reciprocal(const BigInt &v, int p)
 {
-    a = stripLeadingZeros(a);
-    b = stripLeadingZeros(b);
-    if (a == "0") return b;
-    if (b == "0") return a;
-    while (b != "0")
+    BigInt pow2 = shiftLeftBits(BigInt(1), 2 * p);
+    if (p <= NEWTON_BASE_BITS)
     {
-        string r = modStrings(a, b);
-        a = b;
-        b = r;
+        BigInt q, r;
+        divmodKnuth(pow2, v, q, r);
+        return q;
     }
+
+    int h = p / 2 + 2;
+    BigInt x = shiftLeftBits(reciprocal(shiftRightBits(v, p - h), h), p - h);
+    BigInt t = mulBig(v, x);
+    if (compareBig(t, pow2) <= 0)
+        return addBig(x, shiftRightBits(mulBig(x, subBig(pow2, t)), 2 * p));
+    return subBig(x, addBig(shiftRightBits(mulBig(x, subBig(t, pow2)), 2 * p), BigInt(1)));
+}
+
+// Division through a Newton reciprocal; costs a few multiplications.
+void divmodNewton(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r)
+{
+    int na = bitLength(a), nb = bitLength(b);
+    int p = na - nb + 8; // quotient bits plus guard bits
+
+    // b ~ bp * 2^(nb - p), so a / b ~ a * X / 2^(p + nb) with X ~ 2^(2p) / bp
+    BigInt bp = nb >= p ? shiftRightBits(b, nb - p) : shiftLeftBits(b, p - nb);
+    q = shiftRightBits(mulBig(a, reciprocal(bp, p)), p + nb);
+
+    BigInt qb = mulBig(q, b);
+    while (compareBig(qb, a) > 0)
+    {
+        q = subBig(q, BigInt(1));
+        qb = subBig(qb, b);
+    }
+    r = subBig(a, qb);
+    while (compareBig(r, b) >= 0)
+    {
+        q = addBig(q, BigInt(1));
+        r = subBig(r, b);
+    }
+}
+
+// Division by zero gives 0 / 0.
+void divmodBig(const BigInt &a, const BigInt &b, BigInt &q, BigInt &r)
+{
+    q = BigInt();
+    r = BigInt();
+    if (b.isZero()) return;
+    if (compareBig(a, b) < 0)
+    {
+        r = a;
+        return;
+    }
+    if (b.size() == 1)
+    {
+        u64 rem;
+        q = divmodSmall(a, b.d[0], rem);
+        r = BigInt(rem);
+    }
+    else if (b.size() >= NEWTON_DIV_THRESHOLD && a.size() - b.size() >= NEWTON_DIV_THRESHOLD)
+        divmodNewton(a, b, q, r);
+    else
+        divmodKnuth(a, b, q, r);
+}
+
+BigInt divBig(const BigInt &a, const BigInt &b)
+{
+    BigInt q, r;
+    divmodBig(a, b, q, r);
+    return q;
+}
+
+BigInt modBig(const BigInt &a, const BigInt &b)
+{
+    BigInt q, r;
+    divmodBig(a, b, q, r);
+    return r;
+}
+
+// ---------- Operators ----------
+// + and - update an rvalue left operand in place, so chains like a + b + c
+// reuse one buffer. *= and an rvalue-left * write the product into a
+// per-thread spare and swap it with the left operand, whose old buffer
+// becomes the next spare; repeated products alternate between two warm
+// buffers. / and % always return a fresh quotient or remainder.
+//
+// The per-thread buffers are kept only up to RETAIN_MAX_LIMBS (512 KiB
+// each), so one huge product does not pin its buffers in every pool
+// thread for the rest of the process.
+const size_t RETAIN_MAX_LIMBS = 1 << 16;
+
+void releaseIfHuge(vector<u64> &v)
+{
+    if (v.capacity() > RETAIN_MAX_LIMBS) vector<u64>().swap(v);
+}
+
+vector<u64> &threadScratch()
+{
+    static thread_local vector<u64> ws;
+    return ws;
+}
+
+BigInt &threadSpare()
+{
+    static thread_local BigInt t;
+    return t;
+}
+
+BigInt &operator+=(BigInt &a, const BigInt &b)
+{
+    addTo(a, b);
     return a;
 }
 
-// ---------- Increment ----------
-string incrementString(string s)
+BigInt &operator-=(BigInt &a, const BigInt &b)
 {
-    int carry = 1;
-    for (int i = s.length() - 1; i >= 0 && carry; i--)
+    subFrom(a, b);
+    return a;
+}
+
+BigInt &operator*=(BigInt &a, const BigInt &b)
+{
+    BigInt &t = threadSpare();
+    mulInto(t, a, b, threadScratch());
+    a.d.swap(t.d);
+    releaseIfHuge(t.d);
+    releaseIfHuge(threadScratch());
+    return a;
+}
+
+BigInt operator+(BigInt a, const BigInt &b) { return move(a += b); }
+BigInt operator-(BigInt a, const BigInt &b) { return move(a -= b); }
+
+BigInt operator*(BigInt &&a, const BigInt &b) { return move(a *= b); }
+
+BigInt operator*(const BigInt &a, const BigInt &b)
+{
+    BigInt r;
+    mulInto(r, a, b, threadScratch());
+    releaseIfHuge(threadScratch());
+    return r;
+}
+
+BigInt operator/(const BigInt &a, const BigInt &b) { return divBig(a, b); }
+BigInt operator%(const BigInt &a, const BigInt &b) { return modBig(a, b); }
+
+// ---------- GCD ----------
+typedef long long s64;
+typedef __int128 s128;
+
+// Bits [k, k + 62) of a as a single word.
+u64 bitsAt(const BigInt &a, int k)
+{
+    int w = k / 64, s = k % 64;
+    u64 x = w < a.size() ? a.d[w] >> s : 0;
+    if (s && w + 1 < a.size()) x |= a.d[w + 1] << (64 - s);
+    return x & ((1ULL << 62) - 1);
+}
+
+u64 gcdWord(u64 a, u64 b)
+{
+    if (a == 0) return b;
+    if (b == 0) return a;
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    while (b)
+    {
+        b >>= __builtin_ctzll(b);
+        if (a > b) swap(a, b);
+        b -= a;
+    }
+    return a << shift;
+}
+
+// Lehmer's algorithm (Knuth 4.5.2, Algorithm L): Euclid steps are simulated
+// on the leading 62 bits with single-word cofactors, and the collected
+// matrix is applied to the full numbers in one pass. When the leading bits
+// cannot decide even one quotient, a full division step is taken instead.
+BigInt gcdBig(BigInt a, BigInt b)
+{
+    if (compareBig(a, b) < 0) swap(a, b);
+    while (b.size() > 1)
+    {
+        int k = max(0, bitLength(a) - 62);
+        s64 ah = bitsAt(a, k), bh = bitsAt(b, k);
+        s64 A = 1, B = 0, C = 0, D = 1;
+        while (bh + C > 0 && bh + D > 0)
+        {
+            s64 q = (ah + A) / (bh + C);
+            if (q != (ah + B) / (bh + D)) break;
+            s64 t = A - q * C;
+            A = C;
+            C = t;
+            t = B - q * D;
+            B = D;
+            D = t;
+            t = ah - q * bh;
+            ah = bh;
+            bh = t;
+        }
+
+        if (B == 0)
+        {
+            BigInt r = modBig(a, b);
+            a = b;
+            b = r;
+            continue;
+        }
+
+        // (a, b) = (A a + B b, C a + D b); both results are non-negative
+        int n = a.size();
+        b.d.resize(n, 0);
+        s128 ca = 0, cb = 0;
+        for (int i = 0; i < n; i++)
+        {
+            u64 x = a.d[i], y = b.d[i];
+            ca += (s128)A * x + (s128)B * y;
+            cb += (s128)C * x + (s128)D * y;
+            a.d[i] = (u64)ca;
+            b.d[i] = (u64)cb;
+            ca >>= 64;
+            cb >>= 64;
+        }
+        a.trim();
+        b.trim();
+    }
+
+    if (b.isZero()) return a;
+    u64 rem;
+    divmodSmall(a, b.d[0], rem);
+    return BigInt(gcdWord(b.d[0], rem));
+}
+
+// ---------- Factorial ----------
+// Product of the odd parts of lo..hi, split into balanced halves so that the
+// big multiplications see operands of similar size.
+BigInt oddProduct(u64 lo, u64 hi, vector<u64> &ws)
+{
+    BigInt res(1);
+    if (hi - lo < 32)
     {
-        int d = s[i] - '0' + carry;
-        s[i] = char('0' + (d % 10));
-        carry = d / 10;
+        u64 acc = 1;
+        for (u64 i = lo; i <= hi; i++)
+        {
+            u64 x = i >> __builtin_ctzll(i);
+            u128 p = (u128)acc * x;
+            if (p >> 64)
+            {
+                mulSmallTo(res, acc);
+                acc = x;
+            }
+            else acc = (u64)p;
+        }
+        mulSmallTo(res, acc);
+        return res;
     }
-    if (carry) s = '1' + s;
-    return stripLeadingZeros(s);
+    u64 mid = lo + (hi - lo) / 2;
+    mulInto(res, oddProduct(lo, mid, ws), oddProduct(mid + 1, hi, ws), ws);
+    return res;
 }
 
-// ---------- Factorial (string-based) ----------
-string factorialBig(string nStr)
+// n! = (product of odd parts) * 2^(n - popcount(n)), by Legendre's formula.
+BigInt factorialBig(u64 n)
 {
-    nStr = stripLeadingZeros(nStr);
-    if (nStr == "0" || nStr == "1") return "1";
+    if (n < 2) return BigInt(1);
+    vector<u64> ws;
+    return shiftLeftBits(oddProduct(2, n, ws), n - __builtin_popcountll(n));
+}
 
-    string i = "2";
-    string res = "1";
-    while (compareStrings(i, nStr) <= 0)
+// ---------- Power ----------
+// Left-to-right binary exponentiation over the bits of exp.
+BigInt powerBig(const BigInt &base, const BigInt &exp)
+{
+    BigInt res(1), tmp;
+    vector<u64> ws;
+    for (int k = bitLength(exp) - 1; k >= 0; k--)
     {
-        res = multiplyStrings(res, i);
-        i = incrementString(i);
+        mulInto(tmp, res, res, ws);
+        res.d.swap(tmp.d);
+        if (testBit(exp, k))
+        {
+            mulInto(tmp, res, base, ws);
+            res.d.swap(tmp.d);
+        }
     }
-    return stripLeadingZeros(res);
+    return res;
 }
 
-// ---------- Helpers for power ----------
-bool isZero(string s)
+// ---------- Modular exponentiation ----------
+// Low k limbs of a (a mod 2^(64 k)).
+BigInt lowLimbs(const BigInt &a, int k)
 {
-    for (int i = 0; i < (int)s.length(); i++)
-        if (s[i] != '0') return false;
-    return true;
+    return fromLimbs(a.d.data(), min(k, a.size()));
 }
 
-bool isOdd(string s)
+// 2^(64 k) - a for 0 < a < 2^(64 k), i.e. -a mod 2^(64 k).
+BigInt negateLimbs(const BigInt &a, int k)
 {
-    int last = s[s.length() - 1] - '0';
-    return (last % 2 == 1);
+    BigInt res;
+    res.d.assign(k, 0);
+    for (int i = 0; i < k; i++)
+        res.d[i] = ~(i < a.size() ? a.d[i] : 0);
+    addTo(res, BigInt(1));
+    return lowLimbs(res, k);
 }
 
-string divideBy2(string s)
+// Multiplication modulo m. An odd m uses Montgomery form with R = 2^(64 n),
+// where reduction costs two n-limb products and no division; an even m
+// falls back to divmodBig after each product.
+class ModContext
 {
-    string res = "";
-    int carry = 0;
-    for (int i = 0; i < (int)s.length(); i++)
+    BigInt mod, ninv, r2, t, u, v;
+    vector<u64> ws;
+    int n;
+    bool mont;
+
+    // out = x * R^-1 mod m for x < m * R
+    void redc(BigInt &out, const BigInt &x)
     {
-        int cur = carry * 10 + (s[i] - '0');
-        int q = cur / 2;
-        carry = cur % 2;
-        res += char('0' + q);
+        mulInto(u, lowLimbs(x, n), ninv, ws);
+        u = lowLimbs(u, n);
+        mulInto(v, u, mod, ws);
+        addTo(v, x);
+        out = n < v.size() ? fromLimbs(v.d.data() + n, v.size() - n) : BigInt();
+        if (compareBig(out, mod) >= 0) subFrom(out, mod);
     }
-    return stripLeadingZeros(res);
+
+public:
+    explicit ModContext(const BigInt &m) : mod(m), n(m.size()), mont(testBit(m, 0))
+    {
+        if (!mont) return;
+        // m^-1 mod 2^64 by Newton, then lifted limb-precision by doubling
+        u64 w = m.d[0], x = w;
+        for (int i = 0; i < 6; i++)
+            x *= 2 - w * x;
+        BigInt inv(x);
+        for (int k = 1; k < n;)
+        {
+            k = min(2 * k, n);
+            BigInt e = lowLimbs(mulBig(lowLimbs(m, k), inv), k);
+            inv = lowLimbs(mulBig(inv, addBig(negateLimbs(e, k), BigInt(2))), k);
+        }
+        ninv = negateLimbs(inv, n);
+        r2 = modBig(shiftLeftBits(BigInt(1), 128 * n), m);
+    }
+
+    BigInt enter(const BigInt &x)
+    {
+        BigInt r = modBig(x, mod);
+        if (!mont) return r;
+        mulInto(t, r, r2, ws);
+        redc(r, t);
+        return r;
+    }
+
+    BigInt leave(const BigInt &x)
+    {
+        if (!mont) return x;
+        BigInt r;
+        redc(r, x);
+        return r;
+    }
+
+    // out = a * b (in the context's form); out must not alias a or b
+    void mul(BigInt &out, const BigInt &a, const BigInt &b)
+    {
+        mulInto(t, a, b, ws);
+        if (mont) redc(out, t);
+        else
+        {
+            BigInt q;
+            divmodBig(t, mod, q, out);
+        }
+    }
+};
+
+// base^exp mod m by left-to-right sliding windows over exp's bits, with the
+// odd powers base^1, base^3, ..., base^(2^w - 1) precomputed. m == 0 gives 0.
+BigInt modPow(const BigInt &base, const BigInt &exp, const BigInt &m)
+{
+    if (m.isZero() || compareBig(m, BigInt(1)) == 0) return BigInt();
+    int bits = bitLength(exp);
+    int w = bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : 1;
+
+    ModContext ctx(m);
+    vector<BigInt> odd(1 << (w - 1));
+    odd[0] = ctx.enter(base);
+    BigInt sq, tmp;
+    ctx.mul(sq, odd[0], odd[0]);
+    for (int i = 1; i < (int)odd.size(); i++)
+        ctx.mul(odd[i], odd[i - 1], sq);
+
+    BigInt res = ctx.enter(BigInt(1));
+    for (int i = bits - 1; i >= 0;)
+    {
+        if (!testBit(exp, i))
+        {
+            ctx.mul(tmp, res, res);
+            res.d.swap(tmp.d);
+            i--;
+            continue;
+        }
+        // longest window exp[i..l] of at most w bits that ends in a one
+        int l = max(i - w + 1, 0);
+        while (!testBit(exp, l))
+            l++;
+        int val = 0;
+        for (int j = i; j >= l; j--)
+        {
+            val = val * 2 + testBit(exp, j);
+            ctx.mul(tmp, res, res);
+            res.d.swap(tmp.d);
+        }
+        ctx.mul(tmp, res, odd[val >> 1]);
+        res.d.swap(tmp.d);
+        i = l - 1;
+    }
+    return ctx.leave(res);
 }
 
-// ---------- Power (string-based exponent) ----------
-string powerStrings(string base, string expStr)
+// ---------- Decimal conversion ----------
+// Both directions split around the powers 10^(19 * 2^k), built by repeated
+// squaring, and convert the halves recursively, so the cost follows the
+// multiplier and divider instead of growing quadratically. Pieces of up to
+// CONVERT_BASE_LIMBS limbs are converted 19 digits at a time.
+const u64 CHUNK_BASE = 10000000000000000000ULL; // 10^19
+const int CHUNK_DIGITS = 19;
+const int CONVERT_BASE_LIMBS = 32;
+
+BigInt parseChunks(const char *s, int n)
 {
-    base = stripLeadingZeros(base);
-    expStr = stripLeadingZeros(expStr);
-    if (isZero(expStr)) return "1";
+    BigInt res;
+    int first = n % CHUNK_DIGITS;
+    if (first == 0) first = CHUNK_DIGITS;
+    for (int i = 0; i < n;)
+    {
+        int len = (i == 0) ? first : CHUNK_DIGITS;
+        u64 chunk = 0, scale = 1;
+        for (int j = 0; j < len; j++)
+        {
+            chunk = chunk * 10 + (s[i + j] - '0');
+            scale *= 10;
+        }
+        i += len;
 
-    string res = "1";
-    while (!isZero(expStr))
+        // res = res * scale + chunk
+        u64 carry = chunk;
+        for (int k = 0; k < res.size(); k++)
+        {
+            u128 p = (u128)res.d[k] * scale + carry;
+            res.d[k] = (u64)p;
+            carry = (u64)(p >> 64);
+        }
+        if (carry) res.d.push_back(carry);
+    }
+    return res;
+}
+
+string printChunks(const BigInt &a)
+{
+    if (a.isZero()) return "0";
+    vector<u64> chunks;
+    BigInt cur = a;
+    while (!cur.isZero())
+    {
+        u64 rem;
+        cur = divmodSmall(cur, CHUNK_BASE, rem);
+        chunks.push_back(rem);
+    }
+    string s = to_string(chunks.back());
+    for (int i = (int)chunks.size() - 2; i >= 0; i--)
     {
-        if (isOdd(expStr))
-            res = multiplyStrings(res, base);
-        expStr = divideBy2(expStr);
-        if (!isZero(expStr))
-            base = multiplyStrings(base, base);
+        string part = to_string(chunks[i]);
+        s += string(CHUNK_DIGITS - part.length(), '0');
+        s += part;
     }
-    return stripLeadingZeros(res);
+    return s;
 }
 
-// ---------- Operator Precedence ----------
-int precedence(char c)
+// pw[k] = 10^(CHUNK_DIGITS * 2^k)
+void powersOfTen(vector<BigInt> &pw, int k)
 {
-    if (c == 'x' || c == 'X' || c == '*' || c == '/')
-        return 2;
-    if (c == '+' || c == '-')
-        return 1;
-    return 0;
+    if (pw.empty()) pw.push_back(BigInt(CHUNK_BASE));
+    while ((int)pw.size() <= k)
+        pw.push_back(pw.back() * pw.back());
 }
 
-// ---------- Expression Evaluation ----------
-string evaluateExpression(const string &expr)
+BigInt parseDigits(const char *s, int n, vector<BigInt> &pw)
+{
+    if (n <= CONVERT_BASE_LIMBS * CHUNK_DIGITS) return parseChunks(s, n);
+    int k = 0;
+    while ((long long)CHUNK_DIGITS << (k + 1) < n)
+        k++;
+    int low = CHUNK_DIGITS << k;
+    powersOfTen(pw, k);
+    BigInt res = parseDigits(s, n - low, pw) * pw[k];
+    addTo(res, parseDigits(s + n - low, low, pw));
+    return res;
+}
+
+// Appends x < pw[k]^2; with pad, exactly CHUNK_DIGITS * 2^(k+1) digits.
+void printDigits(const BigInt &x, int k, const vector<BigInt> &pw, string &out, bool pad)
+{
+    if (x.size() <= CONVERT_BASE_LIMBS)
+    {
+        string t = printChunks(x);
+        if (pad) out.append((CHUNK_DIGITS << (k + 1)) - t.length(), '0');
+        out += t;
+        return;
+    }
+    BigInt q, r;
+    divmodBig(x, pw[k], q, r);
+    if (pad || !q.isZero())
+    {
+        printDigits(q, k - 1, pw, out, pad);
+        pad = true;
+    }
+    printDigits(r, k - 1, pw, out, pad);
+}
+
+BigInt fromString(const string &s)
+{
+    vector<BigInt> pw;
+    return parseDigits(s.data(), s.length(), pw);
+}
+
+string toString(const BigInt &a)
+{
+    if (a.size() <= CONVERT_BASE_LIMBS) return printChunks(a);
+    vector<BigInt> pw;
+    powersOfTen(pw, 0);
+    while (2 * (bitLength(pw.back()) - 1) < bitLength(a))
+        powersOfTen(pw, pw.size());
+    string out;
+    printDigits(a, pw.size() - 1, pw, out, false);
+    return out;
+}
+
+// ---------- String interface ----------
+string addStrings(const string &a, const string &b)
+{
+    return toString(addBig(fromString(a), fromString(b)));
+}
+
+string subtractStrings(const string &a, const string &b)
+{
+    return toString(subBig(fromString(a), fromString(b)));
+}
+
+string multiplyStrings(const string &a, const string &b)
+{
+    return toString(mulBig(fromString(a), fromString(b)));
+}
+
+string divideStrings(const string &a, const string &b)
+{
+    return toString(divBig(fromString(a), fromString(b)));
+}
+
+string modStrings(const string &a, const string &b)
+{
+    return toString(modBig(fromString(a), fromString(b)));
+}
+
+string gcdStrings(const string &a, const string &b)
+{
+    return toString(gcdBig(fromString(a), fromString(b)));
+}
+
+// n must fit in one limb; larger n is rejected rather than reduced mod 2^64.
+string factorialBig(const string &nStr)
 {
-    string num[2000];
-    char op[2000];
-    int nTop = 0, oTop = 0;
-    string cur = "";
+    BigInt n = fromString(nStr);
+    if (n.size() > 1) throw invalid_argument("factorial argument must be below 2^64");
+    return toString(factorialBig(n.isZero() ? 0 : n.d[0]));
+}
+
+string powerStrings(const string &base, const string &expStr)
+{
+    return toString(powerBig(fromString(base), fromString(expStr)));
+}
+
+// ---------- Thread pool ----------
+// Fixed set of workers over one FIFO queue. A thread waiting on a TaskGroup
+// runs that group's queued tasks itself, so tasks may fork and wait on
+// subtasks without starving the pool (and a pool with no workers still
+// makes progress). It never runs another group's task: a join's latency
+// does not depend on whatever else is queued.
+struct TaskGroup
+{
+    int pending = 0;
+};
+
+class ThreadPool
+{
+    struct Task
+    {
+        TaskGroup *group;
+        function<void()> fn;
+    };
+
+    vector<thread> workers;
+    deque<Task> tasks;
+    mutex mtx;
+    condition_variable cv;
+    bool stopping = false;
+
+public:
+    explicit ThreadPool(int n)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            workers.emplace_back([this] {
+                unique_lock<mutex> lk(mtx);
+                while (true)
+                {
+                    cv.wait(lk, [this] { return stopping || !tasks.empty(); });
+                    if (tasks.empty()) return;
+                    function<void()> task = move(tasks.front().fn);
+                    tasks.pop_front();
+                    lk.unlock();
+                    task();
+                    lk.lock();
+                }
+            });
+        }
+    }
 
-    for (int i = 0; i < (int)expr.length(); i++)
+    ~ThreadPool()
     {
-        char c = expr[i];
-        if (c >= '0' && c <= '9')
-            cur += c;
-        else if (c == '+' || c == '-' || c == 'x' || c == 'X' || c == '*' || c == '/')
         {
-            num[nTop++] = stripLeadingZeros(cur);
-            cur = "";
-            while (oTop > 0 && precedence(op[oTop - 1]) >= precedence(c))
+            lock_guard<mutex> lk(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (thread &t : workers)
+            t.join();
+    }
+
+    void run(TaskGroup &g, function<void()> fn)
+    {
+        {
+            lock_guard<mutex> lk(mtx);
+            g.pending++;
+            function<void()> task = [this, &g, fn] {
+                fn();
+                lock_guard<mutex> lk(mtx);
+                g.pending--;
+                cv.notify_all();
+            };
+            tasks.push_back({&g, move(task)});
+        }
+        cv.notify_all();
+    }
+
+    void wait(TaskGroup &g)
+    {
+        unique_lock<mutex> lk(mtx);
+        while (g.pending > 0)
+        {
+            auto it = tasks.begin();
+            while (it != tasks.end() && it->group != &g)
+                ++it;
+            if (it == tasks.end())
             {
-                string b = num[--nTop];
-                string a = num[--nTop];
-                char oper = op[--oTop];
-                string res = "0";
-                if (oper == '+') res = addStrings(a, b);
-                else if (oper == '-') res = subtractStrings(a, b);
-                else if (oper == 'x' || oper == 'X' || oper == '*') res = multiplyStrings(a, b);
-                else if (oper == '/') res = divideStrings(a, b);
-                num[nTop++] = res;
+                cv.wait(lk); // the rest of g is running elsewhere
+                continue;
             }
-            op[oTop++] = c;
+            function<void()> task = move(it->fn);
+            tasks.erase(it);
+            lk.unlock();
+            task();
+            lk.lock();
         }
     }
-    num[nTop++] = stripLeadingZeros(cur);
 
-    while (oTop > 0)
+    // Blocks until g is done without running anything, for threads that
+    // must not be held up by unrelated tasks (the stream writer).
+    void waitDone(TaskGroup &g)
     {
-        string b = num[--nTop];
-        string a = num[--nTop];
-        char oper = op[--oTop];
-        string res = "0";
-        if (oper == '+') res = addStrings(a, b);
-        else if (oper == '-') res = subtractStrings(a, b);
-        else if (oper == 'x' || oper == 'X' || oper == '*') res = multiplyStrings(a, b);
-        else if (oper == '/') res = divideStrings(a, b);
-        num[nTop++] = res;
+        unique_lock<mutex> lk(mtx);
+        cv.wait(lk, [&g] { return g.pending == 0; });
     }
-    return stripLeadingZeros(num[0]);
+};
+
+// Process-wide pool; the calling thread is the extra worker. There is at
+// least one worker, so tasks progress while every other thread is in
+// waitDone.
+ThreadPool &sharedPool()
+{
+    static ThreadPool pool(max(2u, thread::hardware_concurrency()) - 1);
+    return pool;
 }
 
-// ---------- Main ----------
-int main()
+// Zero workers: tasks run on the thread that waits for them, and no thread
+// is ever started.
+ThreadPool &inlinePool()
 {
-    ios::sync_with_stdio(false);
-    cin.tie(nullptr);
+    static ThreadPool pool(0);
+    return pool;
+}
+
+// a = a oper b, reusing a's storage; tmp and ws are caller-owned scratch.
+void applyOp(char oper, BigInt &a, const BigInt &b, BigInt &tmp, vector<u64> &ws)
+{
+    if (oper == '+') addTo(a, b);
+    else if (oper == '-') subFrom(a, b);
+    else if (oper == 'x')
+    {
+        mulInto(tmp, a, b, ws);
+        a.d.swap(tmp.d);
+    }
+    else if (oper == '/')
+    {
+        BigInt rem;
+        divmodBig(a, b, tmp, rem);
+        a.d.swap(tmp.d);
+    }
+}
+
+// ---------- Expression Evaluation ----------
+// Subtrees and products below this many literal limbs are not worth a task.
+const int PARALLEL_MIN_LIMBS = 256;
+
+// An expression has no parentheses, so it parses into one additive chain
+// (+, -) whose operands are multiplicative chains (x, /) of literals.
+struct ExprNode
+{
+    char assoc = 0;   // '+' or 'x' for chains, 0 for a literal
+    vector<int> kids; // operand node indices
+    vector<char> ops; // ops[i] joins kids[i] to what precedes it
+    BigInt value;     // literal value
+    long long weight = 0; // literal limbs under this node
+};
+
+class Expression
+{
+    vector<ExprNode> nodes;
+
+    int addNode(char assoc)
+    {
+        nodes.emplace_back();
+        nodes.back().assoc = assoc;
+        return nodes.size() - 1;
+    }
+
+    void addOperand(int chain, int kid, char op)
+    {
+        nodes[chain].kids.push_back(kid);
+        nodes[chain].ops.push_back(op);
+        nodes[chain].weight += nodes[kid].weight;
+    }
+
+    // Product or sum of vals[l..r) as a balanced tree; large products fork.
+    BigInt reduceBalanced(vector<BigInt> &vals, int l, int r, char op, ThreadPool &pool) const
+    {
+        if (r - l == 1) return move(vals[l]);
+        int mid = (l + r) / 2;
+        long long w = 0;
+        for (int i = l; i < r; i++)
+            w += vals[i].size();
 
+        BigInt left, right;
+        if (op == 'x' && w >= PARALLEL_MIN_LIMBS)
+        {
+            TaskGroup g;
+            pool.run(g, [&] { left = reduceBalanced(vals, l, mid, op, pool); });
+            right = reduceBalanced(vals, mid, r, op, pool);
+            pool.wait(g);
+        }
+        else
+        {
+            left = reduceBalanced(vals, l, mid, op, pool);
+            right = reduceBalanced(vals, mid, r, op, pool);
+        }
+        if (op == 'x') return left * right;
+        addTo(left, right);
+        return left;
+    }
+
+    // Left fold of a chain. Runs of the associative operator are reduced as
+    // balanced trees first; '-' (clamped) and '/' are applied in order.
+    BigInt foldChain(const ExprNode &nd, vector<BigInt> &vals, ThreadPool &pool) const
+    {
+        int n = vals.size(), i = 1;
+        while (i < n && nd.ops[i] == nd.assoc)
+            i++;
+        BigInt acc = reduceBalanced(vals, 0, i, nd.assoc, pool);
+        BigInt tmp;
+        vector<u64> ws;
+        while (i < n)
+        {
+            applyOp(nd.ops[i], acc, vals[i], tmp, ws);
+            int j = ++i;
+            while (j < n && nd.ops[j] == nd.assoc)
+                j++;
+            if (j > i)
+            {
+                BigInt run = reduceBalanced(vals, i, j, nd.assoc, pool);
+                applyOp(nd.assoc, acc, run, tmp, ws);
+            }
+            i = j;
+        }
+        return acc;
+    }
+
+    BigInt evalNode(int id, ThreadPool &pool) const
+    {
+        const ExprNode &nd = nodes[id];
+        if (nd.assoc == 0) return nd.value;
+
+        int n = nd.kids.size();
+        vector<BigInt> vals(n);
+        TaskGroup g;
+        for (int i = 0; i < n; i++)
+        {
+            int k = nd.kids[i];
+            if (i + 1 < n && nodes[k].weight >= PARALLEL_MIN_LIMBS)
+                pool.run(g, [this, &vals, &pool, i, k] { vals[i] = evalNode(k, pool); });
+            else
+                vals[i] = evalNode(k, pool);
+        }
+        pool.wait(g);
+        return foldChain(nd, vals, pool);
+    }
+
+public:
+    // Parses once; evaluate() may then be called any number of times.
+    explicit Expression(const string &expr)
+    {
+        addNode('+');
+        int term = addNode('x');
+        char mulOp = 'x', addOp = '+';
+        string cur = "";
+        for (int i = 0; i <= (int)expr.length(); i++)
+        {
+            char c = i < (int)expr.length() ? expr[i] : 0;
+            if (c >= '0' && c <= '9')
+            {
+                cur += c;
+                continue;
+            }
+            bool isMul = c == 'x' || c == 'X' || c == '*' || c == '/';
+            if (c != 0 && !isMul && c != '+' && c != '-')
+                continue;
+
+            int leaf = addNode(0);
+            nodes[leaf].value = fromString(cur);
+            nodes[leaf].weight = nodes[leaf].value.size();
+            cur.clear();
+            addOperand(term, leaf, mulOp);
+            if (isMul)
+                mulOp = c == '/' ? '/' : 'x';
+            else
+            {
+                addOperand(0, term, addOp);
+                if (c == 0) break;
+                term = addNode('x');
+                mulOp = 'x';
+                addOp = c;
+            }
+        }
+    }
+
+    BigInt evaluate(ThreadPool &pool) const
+    {
+        return evalNode(0, pool);
+    }
+
+    // Whether the literals are big enough for any task to pay off.
+    bool worthParallel() const
+    {
+        return nodes[0].weight >= PARALLEL_MIN_LIMBS;
+    }
+};
+
+// Small expressions run inline, so a one-shot run never starts the pool.
+BigInt evaluateExpression(const string &expr)
+{
+    Expression e(expr);
+    return e.evaluate(e.worthParallel() ? sharedPool() : inlinePool());
+}
+
+// ---------- Queries ----------
+// 1 expr | 2 base exp | 3 a b | 4 n | 5 base exp mod
+// A query that cannot be answered yields "error: <reason>" in its place.
+struct Query
+{
     int type;
-    cin >> type;
+    string a, b, c;
+};
+
+bool readQuery(istream &in, Query &q)
+{
+    if (!(in >> q.type)) return false;
+    if (q.type == 1 || q.type == 4) return (bool)(in >> q.a);
+    if (q.type == 2 || q.type == 3) return (bool)(in >> q.a >> q.b);
+    if (q.type == 5) return (bool)(in >> q.a >> q.b >> q.c);
+    return false;
+}
 
-    if (type == 1)
+string runQuery(const Query &q)
+{
+    if (q.type == 1) return toString(evaluateExpression(q.a));
+    if (q.type == 2) return toString(powerBig(fromString(q.a), fromString(q.b)));
+    if (q.type == 3) return toString(gcdBig(fromString(q.a), fromString(q.b)));
+    if (q.type == 5) return toString(modPow(fromString(q.a), fromString(q.b), fromString(q.c)));
+    try
     {
-        string expr;
-        cin >> expr;
-        cout << evaluateExpression(expr) << "\n";
+        return factorialBig(q.a);
     }
-    else if (type == 2)
+    catch (const invalid_argument &e)
     {
-        string base, exp;
-        cin >> base >> exp;
-        cout << powerStrings(base, exp) << "\n";
+        return string("error: ") + e.what();
     }
-    else if (type == 3)
+}
+
+// ---------- Streaming mode ----------
+// Reads queries until EOF (or an unknown type) and evaluates them on the
+// shared pool. A writer thread prints each answer, in input order, as soon
+// as it and everything before it are done. At most STREAM_WINDOW queries
+// are in flight, which bounds memory on long inputs.
+const int STREAM_WINDOW = 64;
+
+struct StreamSlot
+{
+    TaskGroup group;
+    string out;
+};
+
+void runStream(istream &in, ostream &out)
+{
+    ThreadPool &pool = sharedPool();
+    deque<StreamSlot *> inFlight;
+    mutex m;
+    condition_variable cv;
+    bool eof = false;
+
+    thread writer([&] {
+        while (true)
+        {
+            StreamSlot *slot;
+            {
+                unique_lock<mutex> lk(m);
+                cv.wait(lk, [&] { return eof || !inFlight.empty(); });
+                if (inFlight.empty()) return;
+                slot = inFlight.front();
+            }
+            pool.waitDone(slot->group);
+            out << slot->out << '\n';
+            out.flush();
+            {
+                lock_guard<mutex> lk(m);
+                inFlight.pop_front();
+            }
+            cv.notify_all();
+            delete slot;
+        }
+    });
+
+    Query q;
+    while (readQuery(in, q))
     {
-        string a, b;
-        cin >> a >> b;
-        cout << gcdStrings(a, b) << "\n";
+        StreamSlot *slot = new StreamSlot();
+        pool.run(slot->group, [slot, q] { slot->out = runQuery(q); });
+        unique_lock<mutex> lk(m);
+        cv.wait(lk, [&] { return (int)inFlight.size() < STREAM_WINDOW; });
+        inFlight.push_back(slot);
+        lk.unlock();
+        cv.notify_all();
     }
-    else if (type == 4)
     {
-        string n;
-        cin >> n;
-        cout << factorialBig(n) << "\n";
+        lock_guard<mutex> lk(m);
+        eof = true;
+    }
+    cv.notify_all();
+    writer.join();
+}
+
+// ---------- Main ----------
+// Default: one query. With --stream: any number of queries until EOF.
+// Q1_NO_MAIN lets other programs (Q1_bench.cpp) include this file.
+#ifndef Q1_NO_MAIN
+int main(int argc, char **argv)
+{
+    ios::sync_with_stdio(false);
+    cin.tie(nullptr);
+
+    if (argc > 1 && string(argv[1]) == "--stream")
+    {
+        runStream(cin, cout);
+        return 0;
     }
+
+    Query q;
+    if (readQuery(cin, q))
+        cout << runQuery(q) << "\n";
     return 0;
 }
+#endif
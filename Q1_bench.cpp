@@ -0,0 +1,371 @@
+// Benchmark and differential checks for the Q1 big-number kernels.
+//
+//   g++ -O2 -o q1_bench Q1_bench.cpp
+//   ./q1_bench [--max-digits N] [--budget-ms T] [--only op,op,...]
+//
+// Each op is swept over operand sizes 10, 20, 50, ... up to --max-digits
+// (default 10^6) until one call takes longer than --budget-ms (default
+// 2000). Every row reports ns/op, heap allocations per op and the local
+// log-log slope against the previous size; the last line per op is the
+// least-squares slope over the whole sweep. Results are checked against
+// the original decimal-string algorithms up to a few thousand digits and
+// against algebraic identities beyond that.
+#define Q1_NO_MAIN
+#include "Q1.cpp"
+#undef Q1_NO_MAIN
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+using namespace std;
+
+// ---------- Allocation counter ----------
+atomic<long long> allocCount(0);
+
+void *operator new(size_t n)
+{
+    allocCount++;
+    void *p = malloc(n ? n : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+// noinline keeps GCC from pairing the inlined free() with operator new
+__attribute__((noinline)) void operator delete(void *p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { free(p); }
+
+// ---------- Reference (decimal string) implementation ----------
+// The original one-digit-per-char algorithms, kept as the ground truth.
+namespace ref
+{
+string strip(const string &s)
+{
+    int i = 0;
+    while (i < (int)s.length() - 1 && s[i] == '0')
+        i++;
+    return s.substr(i);
+}
+
+int compare(const string &a, const string &b)
+{
+    string A = strip(a), B = strip(b);
+    if (A.length() != B.length()) return A.length() < B.length() ? -1 : 1;
+    return A < B ? -1 : (A > B ? 1 : 0);
+}
+
+string add(const string &a, const string &b)
+{
+    int i = a.length() - 1, j = b.length() - 1, carry = 0;
+    string res;
+    while (i >= 0 || j >= 0 || carry)
+    {
+        int sum = (i >= 0 ? a[i--] - '0' : 0) + (j >= 0 ? b[j--] - '0' : 0) + carry;
+        res += char('0' + sum % 10);
+        carry = sum / 10;
+    }
+    reverse(res.begin(), res.end());
+    return strip(res);
+}
+
+string sub(const string &a, const string &b)
+{
+    if (compare(a, b) < 0) return "0";
+    int i = a.length() - 1, j = b.length() - 1, borrow = 0;
+    string res;
+    for (; i >= 0; i--)
+    {
+        int d = a[i] - '0' - borrow - (j >= 0 ? b[j--] - '0' : 0);
+        borrow = d < 0;
+        res += char('0' + (d + 10) % 10);
+    }
+    reverse(res.begin(), res.end());
+    return strip(res);
+}
+
+string mul(const string &a, const string &b)
+{
+    int n = a.length(), m = b.length();
+    vector<int> res(n + m, 0);
+    for (int i = n - 1; i >= 0; i--)
+        for (int j = m - 1; j >= 0; j--)
+        {
+            int sum = (a[i] - '0') * (b[j] - '0') + res[i + j + 1];
+            res[i + j + 1] = sum % 10;
+            res[i + j] += sum / 10;
+        }
+    string s;
+    for (int d : res)
+        s += char('0' + d);
+    return strip(s);
+}
+
+void divmod(const string &a, const string &b, string &q, string &r)
+{
+    q = "";
+    r = "0";
+    if (strip(b) == "0")
+    {
+        q = "0";
+        return;
+    }
+    for (char c : a)
+    {
+        r = strip(r + c);
+        int d = 0;
+        while (compare(r, b) >= 0)
+        {
+            r = sub(r, b);
+            d++;
+        }
+        q += char('0' + d);
+    }
+    q = strip(q);
+}
+
+string gcd(string a, string b)
+{
+    while (strip(b) != "0")
+    {
+        string q, r;
+        divmod(a, b, q, r);
+        a = b;
+        b = r;
+    }
+    return strip(a);
+}
+
+string power(const string &base, long long e)
+{
+    string res = "1";
+    for (long long i = 0; i < e; i++)
+        res = mul(res, base);
+    return res;
+}
+
+string factorial(long long n)
+{
+    string res = "1";
+    for (long long i = 2; i <= n; i++)
+        res = mul(res, to_string(i));
+    return res;
+}
+} // namespace ref
+
+// ---------- Workloads ----------
+mt19937_64 rng(12345);
+
+string randomDigits(int n)
+{
+    string s(n, '0');
+    s[0] = char('1' + rng() % 9);
+    for (int i = 1; i < n; i++)
+        s[i] = char('0' + rng() % 10);
+    return s;
+}
+
+// Smallest n whose factorial has at least the given number of digits.
+long long factorialArgFor(int digits)
+{
+    double logf = 0;
+    long long n = 1;
+    while (logf < digits - 1)
+        logf += log10((double)++n);
+    return n;
+}
+
+// One prepared benchmark case: run() is timed, check() validates one
+// result (returns an error message or "").
+struct Case
+{
+    function<void()> run;
+    function<string()> check;
+};
+
+// Differential checks against ref:: stay below these sizes.
+const int REF_LIMIT = 2000;
+const int REF_GCD_LIMIT = 200;
+
+Case makeCase(const string &op, int digits)
+{
+    Case c;
+    if (op == "add" || op == "sub" || op == "mul")
+    {
+        string sa = randomDigits(digits), sb = randomDigits(digits);
+        if (op == "sub" && ref::compare(sa, sb) < 0) swap(sa, sb);
+        BigInt a = fromString(sa), b = fromString(sb);
+        auto f = [op](const BigInt &x, const BigInt &y) {
+            return op == "add" ? addBig(x, y) : op == "sub" ? subBig(x, y) : mulBig(x, y);
+        };
+        c.run = [=] { f(a, b); };
+        c.check = [=] {
+            BigInt r = f(a, b);
+            if (digits <= REF_LIMIT)
+            {
+                string want = op == "add" ? ref::add(sa, sb) : op == "sub" ? ref::sub(sa, sb) : ref::mul(sa, sb);
+                return toString(r) == want ? string() : "differs from reference";
+            }
+            if (op == "add") return compareBig(subBig(r, b), a) == 0 ? string() : "(a + b) - b != a";
+            if (op == "sub") return compareBig(addBig(r, b), a) == 0 ? string() : "(a - b) + b != a";
+            return compareBig(divBig(r, b), a) == 0 && modBig(r, b).isZero() ? string() : "(a * b) / b != a";
+        };
+    }
+    else if (op == "div" || op == "mod")
+    {
+        // 2n-digit dividend over an n-digit divisor
+        string sa = randomDigits(2 * digits), sb = randomDigits(digits);
+        BigInt a = fromString(sa), b = fromString(sb);
+        c.run = [=] { op == "div" ? divBig(a, b) : modBig(a, b); };
+        c.check = [=] {
+            BigInt q, r;
+            divmodBig(a, b, q, r);
+            if (digits <= REF_LIMIT / 2)
+            {
+                string rq, rr;
+                ref::divmod(sa, sb, rq, rr);
+                return toString(q) == rq && toString(r) == rr ? string() : "differs from reference";
+            }
+            return compareBig(addBig(mulBig(q, b), r), a) == 0 && compareBig(r, b) < 0 ? string() : "q * b + r != a";
+        };
+    }
+    else if (op == "gcd")
+    {
+        // a common factor of about a third of the size keeps the answer nontrivial
+        BigInt g = fromString(randomDigits(max(1, digits / 3)));
+        BigInt a = mulBig(g, fromString(randomDigits(digits - digits / 3)));
+        BigInt b = mulBig(g, fromString(randomDigits(digits - digits / 3)));
+        c.run = [=] { gcdBig(a, b); };
+        c.check = [=] {
+            BigInt r = gcdBig(a, b);
+            if (digits <= REF_GCD_LIMIT)
+                return toString(r) == ref::gcd(toString(a), toString(b)) ? string() : "differs from reference";
+            bool ok = modBig(a, r).isZero() && modBig(b, r).isZero() && modBig(r, g).isZero();
+            return ok ? string() : "gcd does not divide both operands";
+        };
+    }
+    else if (op == "pow")
+    {
+        // 7-digit base, exponent chosen so the result has about `digits` digits
+        string sb = randomDigits(7);
+        long long e = max(1, digits / 7);
+        BigInt base = fromString(sb), exp((u64)e);
+        c.run = [=] { powerBig(base, exp); };
+        c.check = [=] {
+            BigInt r = powerBig(base, exp);
+            if (digits <= REF_LIMIT / 2)
+                return toString(r) == ref::power(sb, e) ? string() : "differs from reference";
+            BigInt half = powerBig(base, BigInt((u64)(e / 2)));
+            BigInt want = mulBig(mulBig(half, half), e % 2 ? base : BigInt(1));
+            return compareBig(r, want) == 0 ? string() : "b^e != (b^(e/2))^2 * b^(e%2)";
+        };
+    }
+    else if (op == "fact")
+    {
+        long long n = factorialArgFor(digits);
+        c.run = [=] { factorialBig((u64)n); };
+        c.check = [=] {
+            BigInt r = factorialBig((u64)n);
+            if (digits <= REF_LIMIT / 2)
+                return toString(r) == ref::factorial(n) ? string() : "differs from reference";
+            BigInt prev = factorialBig((u64)(n - 1));
+            return compareBig(r, mulSmall(prev, n)) == 0 ? string() : "n! != n * (n - 1)!";
+        };
+    }
+    return c;
+}
+
+// ---------- Driver ----------
+struct Sample
+{
+    int digits;
+    double ns;
+};
+
+int main(int argc, char **argv)
+{
+    int maxDigits = 1000000;
+    double budgetMs = 2000;
+    vector<string> ops = {"add", "sub", "mul", "div", "mod", "gcd", "pow", "fact"};
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--max-digits")) maxDigits = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--budget-ms")) budgetMs = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--only"))
+        {
+            ops.clear();
+            string list = argv[i + 1];
+            for (size_t p = 0; p <= list.size();)
+            {
+                size_t q = list.find(',', p);
+                if (q == string::npos) q = list.size();
+                ops.push_back(list.substr(p, q - p));
+                p = q + 1;
+            }
+        }
+    }
+
+    vector<int> sizes;
+    for (long long dec = 10; dec <= maxDigits; dec *= 10)
+        for (int m : {1, 2, 5})
+            if (dec * m <= maxDigits) sizes.push_back(dec * m);
+
+    int failures = 0;
+    printf("%-5s %9s %15s %12s %7s  %s\n", "op", "digits", "ns/op", "allocs/op", "slope", "check");
+    for (const string &op : ops)
+    {
+        vector<Sample> samples;
+        for (int digits : sizes)
+        {
+            Case c = makeCase(op, digits);
+            string err = c.check();
+            if (!err.empty()) failures++;
+
+            // repeat until at least 50 ms have been measured
+            int reps = 0;
+            long long allocs0 = allocCount;
+            auto t0 = chrono::steady_clock::now();
+            double elapsed = 0;
+            do
+            {
+                c.run();
+                reps++;
+                elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+            } while (elapsed < 50e6);
+            double ns = elapsed / reps;
+            double allocs = double(allocCount - allocs0) / reps;
+
+            string slope = "-";
+            if (!samples.empty())
+            {
+                char buf[32];
+                snprintf(buf, sizeof buf, "%.2f", log(ns / samples.back().ns) / log((double)digits / samples.back().digits));
+                slope = buf;
+            }
+            samples.push_back({digits, ns});
+            printf("%-5s %9d %15.0f %12.1f %7s  %s\n", op.c_str(), digits, ns, allocs, slope.c_str(),
+                   err.empty() ? "ok" : ("FAIL: " + err).c_str());
+            fflush(stdout);
+            if (ns > budgetMs * 1e6) break;
+        }
+
+        // least-squares slope of log(ns) against log(digits)
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        int k = samples.size();
+        for (const Sample &s : samples)
+        {
+            double x = log((double)s.digits), y = log(s.ns);
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+        }
+        if (k >= 2)
+            printf("%-5s overall slope %.2f over %d sizes\n\n", op.c_str(), (k * sxy - sx * sy) / (k * sxx - sx * sx), k);
+    }
+
+    if (failures) printf("%d check(s) FAILED\n", failures);
+    return failures ? 1 : 0;
+}
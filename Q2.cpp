@@ -1,10 +1,49 @@
 #include <iostream>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <stdexcept>
+#include <memory>
+#include <functional>
+#include <type_traits>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define Q2_HAVE_MMAP 1
+#endif
 using namespace std;
 
-const int MAX_LEVEL = 16;
-const double P = 0.5;
+const int MAX_LEVEL = 32; // hard cap; a SkipList grows its cap up to this with its size
 unsigned long long rng_seed = 88172645463325252ULL;
 
+// --- Search Statistics ---
+// Built with -DQ2_STATS, every descent counts the levels it visits (skip
+// list levels, B+-tree nodes) and the forward links it follows. Otherwise
+// Q2_STAT compiles to nothing.
+#ifdef Q2_STATS
+struct SearchStats {
+    unsigned long long levels;
+    unsigned long long steps;
+};
+
+SearchStats searchStats;
+#define Q2_STAT(field) (searchStats.field++)
+#else
+#define Q2_STAT(field) ((void)0)
+#endif
+
 unsigned long long nextRand() {
     rng_seed ^= rng_seed << 13;
     rng_seed ^= rng_seed >> 7;
@@ -12,250 +51,1925 @@ unsigned long long nextRand() {
     return rng_seed;
 }
 
+// --- Buffered Output ---
+// All program output goes through one of these: a fixed buffer drained
+// with fwrite, so a million-line replay log is a few hundred syscalls.
+class Writer {
+    static const size_t CAP = 1 << 16;
+    FILE *f;
+    char buf[CAP];
+    size_t len;
+
+public:
+    Writer(FILE *out) {
+        f = out;
+        len = 0;
+    }
+
+    ~Writer() {
+        flush();
+    }
+
+    void flush() {
+        fwrite(buf, 1, len, f);
+        len = 0;
+    }
+
+    Writer &operator<<(char c) {
+        if (len == CAP) flush();
+        buf[len++] = c;
+        return *this;
+    }
+
+    Writer &operator<<(const char *s) {
+        while (*s)
+            *this << *s++;
+        return *this;
+    }
+
+    Writer &operator<<(int v) {
+        char tmp[12];
+        int k = 0;
+        unsigned u = v < 0 ? 0u - (unsigned)v : (unsigned)v;
+        do {
+            tmp[k++] = char('0' + u % 10);
+            u /= 10;
+        } while (u);
+        if (v < 0) *this << '-';
+        while (k)
+            *this << tmp[--k];
+        return *this;
+    }
+};
+
 // --- Node Definition ---
-struct Node {
-    int val;
-    Node **next;
+// Forward pointers live inline right after the header, so a node is one
+// allocation and next[0] usually shares a cache line with the key. Equal
+// keys share one node; count is how many copies it stands for.
+//
+// After the pointers come `level` span widths: span()[i] is the number of
+// elements (counting copies) that link i steps over, including the node it
+// lands on. A null link spans everything up to the end of the list.
+//
+// The head is a node of the same shape whose key and value are never
+// constructed, so no sentinel key is needed.
+struct NoValue {};
+
+template <class Key, class Value>
+struct SkipNode {
     int level;
-    
-    Node(int v, int lvl) {
-        val = v;
-        level = lvl;
-        next = new Node*[lvl];
-        for (int i = 0; i < lvl; i++)
-            next[i] = NULL;
+    int count;
+    Key key;
+    [[no_unique_address]] Value value;
+    SkipNode *next[]; // `level` entries, followed by `level` spans
+
+    int *span() {
+        return (int *)(next + level);
+    }
+
+    static size_t bytes(int lvl) {
+        size_t sz = sizeof(SkipNode) + lvl * (sizeof(SkipNode *) + sizeof(int));
+        return (sz + alignof(SkipNode) - 1) & ~(alignof(SkipNode) - 1);
+    }
+};
+
+// --- Node Arena ---
+// Nodes are carved out of large slabs and recycled through one free list
+// per level, so inserts and deletes almost never reach the allocator. It
+// hands out raw nodes (links cleared, key and value unconstructed); all
+// slabs go back to Alloc when the arena (i.e. the skip list) is destroyed.
+template <class NodeT, int MaxLevel, class Alloc>
+class NodeArena {
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<char> CharAlloc;
+    static const size_t SLAB_BYTES = 1 << 16;
+
+    CharAlloc alloc_;
+    vector<char *> slabs;
+    char *cur;
+    size_t left;
+    NodeT *freeList[MaxLevel + 1];
+
+public:
+    NodeArena() {
+        cur = NULL;
+        left = 0;
+        for (int i = 0; i <= MaxLevel; i++)
+            freeList[i] = NULL;
+    }
+
+    ~NodeArena() {
+        for (char *s : slabs)
+            alloc_.deallocate(s, SLAB_BYTES);
     }
 
-    ~Node() {
-        delete[] next;
+    NodeT *alloc(int lvl) {
+        NodeT *n = freeList[lvl];
+        if (n) {
+            freeList[lvl] = n->next[0];
+        } else {
+            size_t sz = NodeT::bytes(lvl);
+            if (sz > left) {
+                cur = alloc_.allocate(SLAB_BYTES);
+                slabs.push_back(cur);
+                left = SLAB_BYTES;
+            }
+            n = (NodeT *)cur;
+            cur += sz;
+            left -= sz;
+        }
+        n->level = lvl;
+        n->count = 1;
+        for (int i = 0; i < lvl; i++) {
+            n->next[i] = NULL;
+            n->span()[i] = 0;
+        }
+        return n;
+    }
+
+    void release(NodeT *n) {
+        n->next[0] = freeList[n->level];
+        freeList[n->level] = n;
     }
 };
 
+// |a - b| for arithmetic keys, whatever the comparator's direction.
+// Integral keys subtract in the unsigned type, so even LLONG_MIN to
+// LLONG_MAX cannot overflow.
+template <class Key>
+make_unsigned_t<enable_if_t<is_integral<Key>::value, Key>> keyDistance(const Key &a, const Key &b) {
+    typedef make_unsigned_t<Key> U;
+    return a < b ? (U)b - (U)a : (U)a - (U)b;
+}
+
+template <class Key>
+enable_if_t<is_floating_point<Key>::value, Key> keyDistance(const Key &a, const Key &b) {
+    return a < b ? b - a : a - b;
+}
+
 // --- SkipList Class ---
+// Ordered multiset (or multimap: one Value per distinct key) over any Key
+// with a strict weak order Compare. MaxLevel and the level probability
+// PNum/PDen are compile-time parameters; nodes come from Alloc through the
+// arena. Queries that can miss return Key() (0 for int keys).
+//
+// The level cap is levelCap, not MaxLevel: head has levelCap levels, which
+// suit about (PDen/PNum)^(levelCap - 1) elements. Once total passes growAt
+// the cap goes up by one and head is reallocated, so small lists stay
+// short and large ones keep O(log n) searches up to MaxLevel.
+template <class Key, class Value = NoValue, class Compare = less<Key>, class Alloc = allocator<Key>,
+          int MaxLevel = MAX_LEVEL, unsigned PNum = 1, unsigned PDen = 2>
 class SkipList {
+    static_assert(MaxLevel >= 1, "MaxLevel must be positive");
+    static_assert(0 < PNum && PNum < PDen, "level probability must be in (0, 1)");
+
+public:
+    typedef Key key_type;
+    typedef Compare key_compare;
+
+private:
+    typedef SkipNode<Key, Value> Node;
+
+    // Bulk loaders append in key order: node[i] is the last node on level
+    // i and rank[i] the number of elements up to and including it.
+    struct Tails {
+        Node *node[MaxLevel];
+        int rank[MaxLevel];
+    };
+
+    static const int INITIAL_LEVELS = MaxLevel < 4 ? MaxLevel : 4;
+
+    NodeArena<Node, MaxLevel, Alloc> arena;
+    [[no_unique_address]] Compare comp;
     Node *head;
     int currLevel;
+    int levelCap; // levels in head; no node is taller
+    double growAt;
+    int total;    // elements, counting copies
+
+    // finger[i] is the last node before fingerKey on level i, left behind
+    // by the previous query. A query for a nearby key climbs only until the
+    // finger path brackets it and descends from there, O(log d) for a key d
+    // elements away. Inserts keep the finger usable (its nodes stay alive);
+    // deleteAll and clear free nodes, so they drop it.
+    Node *finger[MaxLevel];
+    Key fingerKey;
+    bool fingerValid;
+
+    bool equal(const Key &a, const Key &b) const {
+        return !comp(a, b) && !comp(b, a);
+    }
+
+    // Last node before k on level 0 (head if none), searched from the
+    // finger, which is then moved to k.
+    Node *fingerPred(const Key &k) {
+        int top;
+        if (!fingerValid) {
+            for (int i = 0; i < MaxLevel; i++)
+                finger[i] = head;
+            fingerValid = true;
+            top = currLevel - 1;
+        } else if (comp(fingerKey, k)) {
+            // climb while the finger level still has a node before k
+            top = 0;
+            while (top + 1 < currLevel && finger[top]->next[top] && comp(finger[top]->next[top]->key, k))
+                top++;
+        } else {
+            // climb until the finger node lies before k
+            top = 0;
+            while (top + 1 < currLevel && finger[top] != head && !comp(finger[top]->key, k))
+                top++;
+        }
+
+        Node *x = head;
+        for (int i = top; i >= 0; i--) {
+            Q2_STAT(levels);
+            Node *f = finger[i];
+            if (f != head && comp(f->key, k) && (x == head || comp(x->key, f->key)))
+                x = f;
+            while (x->next[i] && comp(x->next[i]->key, k)) {
+                Q2_STAT(steps);
+                x = x->next[i];
+            }
+            finger[i] = x;
+        }
+        fingerKey = k;
+        return x;
+    }
+
+    // Elements < k (or <= k when inclusive), summed from the spans of the
+    // links the search crosses.
+    int countBelow(const Key &k, bool inclusive) const {
+        Node *x = head;
+        int cnt = 0;
+        for (int i = currLevel - 1; i >= 0; i--) {
+            Q2_STAT(levels);
+            while (x->next[i] && (inclusive ? !comp(k, x->next[i]->key) : comp(x->next[i]->key, k))) {
+                Q2_STAT(steps);
+                cnt += x->span()[i];
+                x = x->next[i];
+            }
+        }
+        return cnt;
+    }
+
+    // Raises levelCap until it suits n elements, reallocating head. Any
+    // saved search path through the old head is stale afterwards.
+    void reserveLevels(long long n) {
+        int cap = levelCap;
+        while (cap < MaxLevel && n > growAt) {
+            cap++;
+            growAt *= (double)PDen / PNum;
+        }
+        if (cap == levelCap) return;
+
+        Node *h = arena.alloc(cap);
+        for (int i = 0; i < levelCap; i++) {
+            h->next[i] = head->next[i];
+            h->span()[i] = head->span()[i];
+        }
+        arena.release(head);
+        head = h;
+        levelCap = cap;
+        fingerValid = false;
+    }
 
+    // For P = 1/2^b, one random word decides every coin flip at once: the
+    // level is 1 + (trailing zero bits) / b. Other P values flip one coin
+    // per level.
     int randomLevel() {
+        if (PNum == 1 && (PDen & (PDen - 1)) == 0) {
+            const int bits = __builtin_ctz(PDen);
+            unsigned long long r = nextRand();
+            int lvl = r ? 1 + __builtin_ctzll(r) / bits : levelCap;
+            return min(lvl, levelCap);
+        }
         int lvl = 1;
-        while ((nextRand() & 1) && lvl < MAX_LEVEL)
+        while (lvl < levelCap && nextRand() % PDen < PNum)
             lvl++;
         return lvl;
     }
 
-public:
-    SkipList() {
-        currLevel = 1;
-        head = new Node(-1000000000, MAX_LEVEL); // sentinel node
+    // Level for the j-th (1-based) distinct key of a bulk load: the ideal
+    // shape for P = 1/PDen, with no random numbers. Other P values fall
+    // back to randomLevel.
+    int bulkLevel(unsigned j) {
+        if (PNum != 1) return randomLevel();
+        int lvl = 1;
+        while (lvl < levelCap && j % PDen == 0) {
+            j /= PDen;
+            lvl++;
+        }
+        return lvl;
     }
 
-    ~SkipList() {
-        Node *cur = head->next[0];
-        while (cur) {
-            Node *nxt = cur->next[0];
-            delete cur;
-            cur = nxt;
+    Node *makeNode(const Key &k, const Value &v, int lvl) {
+        Node *n = arena.alloc(lvl);
+        new (&n->key) Key(k);
+        new (&n->value) Value(v);
+        return n;
+    }
+
+    void freeNode(Node *n) {
+        n->key.~Key();
+        n->value.~Value();
+        arena.release(n);
+    }
+
+    void beginAppend(Tails &t, long long n) {
+        clear();
+        reserveLevels(n);
+        for (int i = 0; i < MaxLevel; i++) {
+            t.node[i] = head;
+            t.rank[i] = 0;
         }
-        delete head;
     }
 
-    // --- Insert operation ---
-    void insert(int val) {
-        Node *update[MAX_LEVEL];
-        Node *x = head;
+    void append(Tails &t, const Key &k, int count, int lvl) {
+        Node *n = makeNode(k, Value(), lvl);
+        n->count = count;
+        total += count;
+        for (int i = 0; i < lvl; i++) {
+            t.node[i]->next[i] = n;
+            t.node[i]->span()[i] = total - t.rank[i];
+            t.node[i] = n;
+            t.rank[i] = total;
+        }
+        currLevel = max(currLevel, lvl);
+    }
+
+    void finishAppend(Tails &t) {
+        for (int i = 0; i < currLevel; i++)
+            t.node[i]->span()[i] = total - t.rank[i];
+    }
 
+    // Fills update[i] with the last node before k on level i, and rank[i]
+    // with the number of elements up to and including it. With useFinger,
+    // update/rank already hold the path of a smaller key, and each level
+    // resumes from there whenever that is further right than the descent.
+    void findPath(const Key &k, Node **update, int *rank, bool useFinger) {
+        Node *x = head;
+        int r = 0;
         for (int i = currLevel - 1; i >= 0; i--) {
-            while (x->next[i] && x->next[i]->val < val)
+            Q2_STAT(levels);
+            if (useFinger && rank[i] > r) {
+                x = update[i];
+                r = rank[i];
+            }
+            while (x->next[i] && comp(x->next[i]->key, k)) {
+                Q2_STAT(steps);
+                r += x->span()[i];
                 x = x->next[i];
+            }
             update[i] = x;
+            rank[i] = r;
+        }
+    }
+
+    // Inserts one copy of k given its search path and returns its node. The
+    // path stays valid (nodes before k, ranks unchanged) so it can seed the
+    // search for any key >= k.
+    Node *insertAt(const Key &k, Node **update, int *rank) {
+        // a repeat only bumps the count of the existing node; every link
+        // on the search path steps over or onto it
+        Node *x = update[0]->next[0];
+        if (x && equal(x->key, k)) {
+            x->count++;
+            for (int i = 0; i < currLevel; i++)
+                update[i]->span()[i]++;
+            total++;
+            return x;
         }
 
         int lvl = randomLevel();
         if (lvl > currLevel) {
-            for (int i = currLevel; i < lvl; i++)
+            for (int i = currLevel; i < lvl; i++) {
                 update[i] = head;
+                rank[i] = 0;
+                head->span()[i] = total;
+            }
             currLevel = lvl;
         }
 
-        Node *n = new Node(val, lvl);
+        Node *n = makeNode(k, Value(), lvl);
         for (int i = 0; i < lvl; i++) {
             n->next[i] = update[i]->next[i];
             update[i]->next[i] = n;
+            int before = rank[0] - rank[i]; // elements between update[i] and n
+            n->span()[i] = update[i]->span()[i] - before;
+            update[i]->span()[i] = before + 1;
+        }
+        for (int i = lvl; i < currLevel; i++)
+            update[i]->span()[i]++;
+        total++;
+        return n;
+    }
+
+public:
+    explicit SkipList(const Compare &c = Compare()) : comp(c) {
+        currLevel = 1;
+        total = 0;
+        fingerValid = false;
+        levelCap = INITIAL_LEVELS;
+        growAt = 1;
+        for (int i = 1; i < levelCap; i++)
+            growAt *= (double)PDen / PNum;
+        head = arena.alloc(levelCap); // key and value stay unconstructed
+    }
+
+    ~SkipList() {
+        if (!is_trivially_destructible<Key>::value || !is_trivially_destructible<Value>::value)
+            clear();
+    }
+
+    SkipList(const SkipList &) = delete;
+    SkipList &operator=(const SkipList &) = delete;
+
+    int size() const {
+        return total;
+    }
+
+    // --- Insert operation ---
+    void insert(const Key &k) {
+        reserveLevels(total + 1LL);
+        Node *update[MaxLevel];
+        int rank[MaxLevel];
+        findPath(k, update, rank, false);
+        insertAt(k, update, rank);
+    }
+
+    // --- Map-style access ---
+    // Payload of k, inserting k once with Value() if it is absent.
+    Value &operator[](const Key &k) {
+        Node *x = fingerPred(k)->next[0];
+        if (x && equal(x->key, k)) return x->value;
+        reserveLevels(total + 1LL);
+        Node *update[MaxLevel];
+        int rank[MaxLevel];
+        findPath(k, update, rank, false);
+        return insertAt(k, update, rank)->value;
+    }
+
+    // Payload of k, or NULL if absent.
+    Value *find(const Key &k) {
+        Node *x = fingerPred(k)->next[0];
+        return (x && equal(x->key, k)) ? &x->value : NULL;
+    }
+
+    // --- Batched insert ---
+    // Sorts the batch and inserts in ascending order, starting each search
+    // from the previous key's path instead of from head.
+    void insertBatch(vector<Key> keys) {
+        sort(keys.begin(), keys.end(), comp);
+        reserveLevels(total + (long long)keys.size());
+        Node *update[MaxLevel];
+        int rank[MaxLevel];
+        for (int i = 0; i < MaxLevel; i++) {
+            update[i] = head;
+            rank[i] = 0;
+        }
+        for (const Key &k : keys) {
+            findPath(k, update, rank, true);
+            insertAt(k, update, rank);
+        }
+    }
+
+    // --- Bulk load ---
+    // Replaces the contents with the given keys in one linear pass, with
+    // levels from bulkLevel.
+    void bulkLoad(const vector<Key> &keys) {
+        if (!is_sorted(keys.begin(), keys.end(), comp)) {
+            vector<Key> sorted(keys);
+            sort(sorted.begin(), sorted.end(), comp);
+            bulkLoad(sorted);
+            return;
+        }
+        Tails t;
+        beginAppend(t, keys.size());
+        unsigned distinct = 0;
+        for (size_t s = 0; s < keys.size();) {
+            size_t e = s + 1;
+            while (e < keys.size() && !comp(keys[s], keys[e]))
+                e++;
+            append(t, keys[s], e - s, bulkLevel(++distinct));
+            s = e;
+        }
+        finishAppend(t);
+    }
+
+    // --- Load (key, count, level) runs ---
+    // Replaces the contents; keys must be strictly increasing. A level hint
+    // of 0 lets bulkLevel choose, and hints above levelCap are clamped.
+    void loadCounted(const Key *keys, const int *counts, const unsigned char *levels, size_t n) {
+        Tails t;
+        beginAppend(t, n);
+        for (size_t j = 0; j < n; j++) {
+            int lvl = levels[j] ? min((int)levels[j], levelCap) : bulkLevel(j + 1);
+            append(t, keys[j], counts[j], lvl);
+        }
+        finishAppend(t);
+    }
+
+    // Calls f(key, count, level) for every node in key order.
+    template <class F>
+    void forEachNode(F f) const {
+        for (Node *x = head->next[0]; x; x = x->next[0])
+            f(x->key, x->count, x->level);
+    }
+
+    // --- Remove everything ---
+    void clear() {
+        Node *x = head->next[0];
+        while (x) {
+            Node *nx = x->next[0];
+            freeNode(x);
+            x = nx;
         }
+        for (int i = 0; i < levelCap; i++) {
+            head->next[i] = NULL;
+            head->span()[i] = 0;
+        }
+        currLevel = 1;
+        total = 0;
+        fingerValid = false;
     }
 
     // --- Delete All occurrences of a value ---
-    void deleteAll(int val) {
-        Node *update[MAX_LEVEL];
+    void deleteAll(const Key &k) {
+        Node *update[MaxLevel];
         Node *x = head;
 
         for (int i = currLevel - 1; i >= 0; i--) {
-            while (x->next[i] && x->next[i]->val < val)
+            Q2_STAT(levels);
+            while (x->next[i] && comp(x->next[i]->key, k)) {
+                Q2_STAT(steps);
                 x = x->next[i];
+            }
             update[i] = x;
         }
 
+        // all copies live in one node, so a single unlink removes them
         x = x->next[0];
-        bool deleted = false;
-        while (x && x->val == val) {
-            for (int i = 0; i < x->level; i++) {
-                if (update[i]->next[i] == x)
-                    update[i]->next[i] = x->next[i];
-            }
-            Node *tmp = x;
-            x = x->next[0];
-            delete tmp;
-            deleted = true;
+        if (!x || !equal(x->key, k)) return;
+        for (int i = 0; i < x->level; i++) {
+            update[i]->next[i] = x->next[i];
+            update[i]->span()[i] += x->span()[i] - x->count;
         }
+        for (int i = x->level; i < currLevel; i++)
+            update[i]->span()[i] -= x->count;
+        total -= x->count;
+        freeNode(x);
+        fingerValid = false;
 
-        if (deleted) {
-            while (currLevel > 1 && head->next[currLevel - 1] == NULL)
-                currLevel--;
-        }
+        while (currLevel > 1 && head->next[currLevel - 1] == NULL)
+            currLevel--;
     }
 
     // --- Search value ---
-    bool search(int val) {
+    bool search(const Key &k) {
+        Node *x = fingerPred(k)->next[0];
+        return (x && equal(x->key, k));
+    }
+
+    // --- Count Occurrence ---
+    int countOccurrence(const Key &k) {
+        Node *x = fingerPred(k)->next[0];
+        return (x && equal(x->key, k)) ? x->count : 0;
+    }
+
+    // --- Lower Bound ---
+    Key lowerBound(const Key &k) {
+        Node *x = fingerPred(k)->next[0];
+        return x ? x->key : Key();
+    }
+
+    // --- Upper Bound ---
+    Key upperBound(const Key &k) {
+        Node *x = fingerPred(k)->next[0];
+        if (x && !comp(k, x->key)) x = x->next[0]; // skip the node equal to k
+        return x ? x->key : Key();
+    }
+
+    // --- Closest Element ---
+    // Nearest key by |key - k|; on a tie, the one Compare puts first.
+    Key closestElement(const Key &k) {
+        static_assert(is_arithmetic<Key>::value, "closestElement needs arithmetic keys");
+        Node *x = fingerPred(k);
+
+        Node *pred = (x == head ? NULL : x);
+        Node *succ = x->next[0];
+
+        if (succ && equal(succ->key, k)) return succ->key;
+        if (!pred && !succ) return Key();
+        if (!pred) return succ->key;
+        if (!succ) return pred->key;
+        return keyDistance(pred->key, k) <= keyDistance(k, succ->key) ? pred->key : succ->key;
+    }
+
+    // --- Rank: number of elements strictly less than k ---
+    int rank(const Key &k) const {
+        return countBelow(k, false);
+    }
+
+    // --- Select: k-th smallest element (1-based, Key() if out of range) ---
+    Key select(int k) const {
+        if (k < 1 || k > total) return Key();
         Node *x = head;
+        int pos = 0;
         for (int i = currLevel - 1; i >= 0; i--) {
-            while (x->next[i] && x->next[i]->val < val)
+            Q2_STAT(levels);
+            while (x->next[i] && pos + x->span()[i] < k) {
+                Q2_STAT(steps);
+                pos += x->span()[i];
                 x = x->next[i];
+            }
         }
-        x = x->next[0];
-        return (x && x->val == val);
+        return x->next[0]->key;
+    }
+
+    // --- Count of elements in [lo, hi] ---
+    int countInRange(const Key &lo, const Key &hi) const {
+        if (comp(hi, lo)) return 0;
+        return countBelow(hi, true) - countBelow(lo, false);
+    }
+
+    // --- Print the base level of skip list ---
+    void printBottom(Writer &out) const {
+        const char *sep = "";
+        for (Node *x = head->next[0]; x; x = x->next[0]) {
+            for (int c = 0; c < x->count; c++) {
+                out << sep << x->key;
+                sep = " ";
+            }
+        }
+        out << '\n';
+    }
+};
+
+// --- B+-tree Node Definitions ---
+// Keys sit in one cache line per node (16 ints) and are searched with SIMD
+// compares. Unused key slots hold INT_MAX so a full-width compare never
+// counts them. Leaves keep each distinct value once with its multiplicity
+// and are chained both ways for the neighbour lookups in closestElement.
+// Inner nodes store, per child, the smallest key that may live under it
+// (INT_MIN for the first child) and how many elements it holds, which
+// gives rank and select in O(log n).
+const int BT_ORDER = 16;
+
+// keys come first in a 64-byte aligned node, so each countLess probe reads
+// exactly one cache line.
+struct alignas(64) BTNode {
+    int keys[BT_ORDER];
+    int cnt[BT_ORDER]; // leaf: multiplicity; inner: elements under child
+    bool leaf;
+    int n; // keys in a leaf, children in an inner node
+
+    BTNode(bool isLeaf) {
+        leaf = isLeaf;
+        n = 0;
+        for (int i = 0; i < BT_ORDER; i++) {
+            keys[i] = INT_MAX;
+            cnt[i] = 0;
+        }
+    }
+};
+
+struct BTLeaf : BTNode {
+    BTLeaf *prev, *next;
+
+    BTLeaf() : BTNode(true), prev(NULL), next(NULL) {}
+};
+
+struct BTInner : BTNode {
+    BTNode *child[BT_ORDER];
+
+    BTInner() : BTNode(false) {}
+};
+
+// Number of keys < val in a padded 16-key block.
+inline int countLess(const int *keys, int val) {
+#ifdef __SSE2__
+    __m128i v = _mm_set1_epi32(val);
+    int mask = 0;
+    for (int i = 0; i < BT_ORDER; i += 4) {
+        __m128i k = _mm_loadu_si128((const __m128i *)(keys + i));
+        mask |= _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(k, v))) << i;
+    }
+    return __builtin_popcount(mask);
+#else
+    int c = 0;
+    for (int i = 0; i < BT_ORDER; i++)
+        c += keys[i] < val;
+    return c;
+#endif
+}
+
+inline int countLessEq(const int *keys, int n, int val) {
+    return val == INT_MAX ? n : countLess(keys, val + 1);
+}
+
+// --- B+-tree Multiset Class ---
+// Drop-in alternative to SkipList (same query interface), selected with
+// -DQ2_BTREE_BACKEND. Deletions merge a node into its neighbour whenever
+// the two fit together, so adjacent nodes are always more than half full
+// on average.
+class BTreeMultiset {
+public:
+    typedef int key_type;
+    typedef less<int> key_compare;
+
+private:
+    BTNode *root;
+    int total;
+
+    // child of an inner node that may contain val
+    static int route(const BTNode *x, int val) {
+        int i = countLessEq(x->keys, x->n, val) - 1;
+        return i < 0 ? 0 : i;
+    }
+
+    static void insertSlot(BTNode *x, int pos, int key, int c) {
+        for (int i = x->n; i > pos; i--) {
+            x->keys[i] = x->keys[i - 1];
+            x->cnt[i] = x->cnt[i - 1];
+        }
+        x->keys[pos] = key;
+        x->cnt[pos] = c;
+        x->n++;
+    }
+
+    static void removeSlot(BTNode *x, int pos) {
+        for (int i = pos; i + 1 < x->n; i++) {
+            x->keys[i] = x->keys[i + 1];
+            x->cnt[i] = x->cnt[i + 1];
+        }
+        x->n--;
+        x->keys[x->n] = INT_MAX;
+        x->cnt[x->n] = 0;
+    }
+
+    static void insertChild(BTInner *x, int pos, int key, int c, BTNode *ch) {
+        for (int i = x->n; i > pos; i--)
+            x->child[i] = x->child[i - 1];
+        x->child[pos] = ch;
+        insertSlot(x, pos, key, c);
+    }
+
+    static void removeChild(BTInner *x, int pos) {
+        for (int i = pos; i + 1 < x->n; i++)
+            x->child[i] = x->child[i + 1];
+        removeSlot(x, pos);
+    }
+
+    // Moves the upper half of a full node into a new right sibling.
+    static BTNode *split(BTNode *x) {
+        int half = x->n / 2;
+        BTNode *r;
+        if (x->leaf) {
+            BTLeaf *l = (BTLeaf *)x, *nl = new BTLeaf();
+            nl->next = l->next;
+            nl->prev = l;
+            if (l->next) l->next->prev = nl;
+            l->next = nl;
+            r = nl;
+        } else {
+            BTInner *in = (BTInner *)x, *ni = new BTInner();
+            for (int i = half; i < x->n; i++)
+                ni->child[i - half] = in->child[i];
+            r = ni;
+        }
+        for (int i = half; i < x->n; i++) {
+            r->keys[i - half] = x->keys[i];
+            r->cnt[i - half] = x->cnt[i];
+            x->keys[i] = INT_MAX;
+            x->cnt[i] = 0;
+        }
+        r->n = x->n - half;
+        x->n = half;
+        return r;
+    }
+
+    static int sumCounts(const BTNode *x) {
+        int s = 0;
+        for (int i = 0; i < x->n; i++)
+            s += x->cnt[i];
+        return s;
+    }
+
+    // Returns a new right sibling if x had to split.
+    BTNode *insertRec(BTNode *x, int val) {
+        Q2_STAT(levels);
+        if (x->leaf) {
+            int pos = countLess(x->keys, val);
+            if (pos < x->n && x->keys[pos] == val) {
+                x->cnt[pos]++;
+                return NULL;
+            }
+            BTNode *r = NULL;
+            if (x->n == BT_ORDER) {
+                r = split(x);
+                if (pos > x->n) {
+                    insertSlot(r, pos - x->n, val, 1);
+                    return r;
+                }
+            }
+            insertSlot(x, pos, val, 1);
+            return r;
+        }
+
+        BTInner *in = (BTInner *)x;
+        int i = route(in, val);
+        in->cnt[i]++;
+        BTNode *r = insertRec(in->child[i], val);
+        if (!r) return NULL;
+
+        int moved = sumCounts(r);
+        in->cnt[i] -= moved;
+        int sep = r->keys[0];
+        if (!r->leaf) r->keys[0] = INT_MIN;
+        BTNode *up = NULL;
+        if (in->n == BT_ORDER) {
+            up = split(in);
+            if (i + 1 > in->n) {
+                insertChild((BTInner *)up, i + 1 - in->n, sep, moved, r);
+                return up;
+            }
+        }
+        insertChild(in, i + 1, sep, moved, r);
+        return up;
+    }
+
+    static void unlinkLeaf(BTLeaf *l) {
+        if (l->prev) l->prev->next = l->next;
+        if (l->next) l->next->prev = l->prev;
+    }
+
+    // Folds child j + 1 into child j (they are known to fit together).
+    static void mergeChildren(BTInner *x, int j) {
+        BTNode *a = x->child[j], *b = x->child[j + 1];
+        if (!a->leaf) {
+            for (int k = 0; k < b->n; k++)
+                ((BTInner *)a)->child[a->n + k] = ((BTInner *)b)->child[k];
+        }
+        for (int k = 0; k < b->n; k++) {
+            a->keys[a->n + k] = (k == 0 && !b->leaf) ? x->keys[j + 1] : b->keys[k];
+            a->cnt[a->n + k] = b->cnt[k];
+        }
+        a->n += b->n;
+        x->cnt[j] += x->cnt[j + 1];
+        removeChild(x, j + 1);
+        if (b->leaf) {
+            unlinkLeaf((BTLeaf *)b);
+            delete (BTLeaf *)b;
+        } else {
+            delete (BTInner *)b;
+        }
+    }
+
+    // Removes val under x; returns how many copies went away.
+    int eraseRec(BTNode *x, int val) {
+        Q2_STAT(levels);
+        if (x->leaf) {
+            int pos = countLess(x->keys, val);
+            if (pos >= x->n || x->keys[pos] != val) return 0;
+            int c = x->cnt[pos];
+            removeSlot(x, pos);
+            return c;
+        }
+
+        BTInner *in = (BTInner *)x;
+        int i = route(in, val);
+        int c = eraseRec(in->child[i], val);
+        if (!c) return 0;
+        in->cnt[i] -= c;
+
+        BTNode *ch = in->child[i];
+        if (ch->n == 0) {
+            if (ch->leaf) {
+                unlinkLeaf((BTLeaf *)ch);
+                delete (BTLeaf *)ch;
+            } else {
+                delete (BTInner *)ch;
+            }
+            removeChild(in, i);
+            if (i == 0 && in->n) in->keys[0] = INT_MIN;
+        } else if (i + 1 < in->n && ch->n + in->child[i + 1]->n <= BT_ORDER) {
+            mergeChildren(in, i);
+        } else if (i > 0 && in->child[i - 1]->n + ch->n <= BT_ORDER) {
+            mergeChildren(in, i - 1);
+        }
+        return c;
+    }
+
+    // Leaf that would hold val, and the slot of the first key >= val.
+    BTLeaf *findLeaf(int val, int &pos) const {
+        BTNode *x = root;
+        Q2_STAT(levels);
+        while (!x->leaf) {
+            x = ((BTInner *)x)->child[route(x, val)];
+            Q2_STAT(levels);
+        }
+        pos = countLess(x->keys, val);
+        return (BTLeaf *)x;
+    }
+
+    // First (leaf, slot) with key >= val; leaf is NULL past the end.
+    BTLeaf *firstAtLeast(int val, int &pos) const {
+        BTLeaf *l = findLeaf(val, pos);
+        while (l && pos >= l->n) {
+            Q2_STAT(steps);
+            l = l->next;
+            pos = 0;
+        }
+        return l;
+    }
+
+    // Elements < val (<= val when inclusive).
+    int countBelow(int val, bool inclusive) const {
+        BTNode *x = root;
+        int c = 0;
+        while (!x->leaf) {
+            Q2_STAT(levels);
+            int i = route(x, val);
+            for (int k = 0; k < i; k++)
+                c += x->cnt[k];
+            x = ((BTInner *)x)->child[i];
+        }
+        Q2_STAT(levels);
+        int pos = inclusive ? countLessEq(x->keys, x->n, val) : countLess(x->keys, val);
+        for (int k = 0; k < pos; k++)
+            c += x->cnt[k];
+        return c;
+    }
+
+    static void destroy(BTNode *x) {
+        if (x->leaf) {
+            delete (BTLeaf *)x;
+            return;
+        }
+        BTInner *in = (BTInner *)x;
+        for (int i = 0; i < in->n; i++)
+            destroy(in->child[i]);
+        delete in;
+    }
+
+public:
+    BTreeMultiset() {
+        root = new BTLeaf();
+        total = 0;
+    }
+
+    ~BTreeMultiset() {
+        destroy(root);
+    }
+
+    BTreeMultiset(const BTreeMultiset &) = delete;
+    BTreeMultiset &operator=(const BTreeMultiset &) = delete;
+
+    // --- Batched insert ---
+    // Same interface as SkipList::insertBatch; sorted, so consecutive
+    // inserts walk the same root-to-leaf path while it is still cached.
+    void insertBatch(vector<int> keys) {
+        sort(keys.begin(), keys.end());
+        for (int k : keys)
+            insert(k);
+    }
+
+    // --- Bulk load ---
+    // Replaces the contents with the given keys, packed by loadCounted.
+    void bulkLoad(vector<int> keys) {
+        sort(keys.begin(), keys.end());
+        vector<int> distinct, counts;
+        for (size_t s = 0; s < keys.size();) {
+            size_t e = s + 1;
+            while (e < keys.size() && keys[e] == keys[s])
+                e++;
+            distinct.push_back(keys[s]);
+            counts.push_back((int)(e - s));
+            s = e;
+        }
+        loadCounted(distinct.data(), counts.data(), NULL, distinct.size());
+    }
+
+    // --- Load (key, count) runs ---
+    // Replaces the contents; keys must be strictly increasing. Nodes are
+    // packed full left to right, bottom-up. Level hints are ignored.
+    void loadCounted(const int *keys, const int *counts, const unsigned char *, size_t n) {
+        destroy(root);
+        total = 0;
+        if (n == 0) {
+            root = new BTLeaf();
+            return;
+        }
+
+        vector<BTNode *> nodes;
+        vector<int> mins; // smallest key under each node
+        BTLeaf *prev = NULL;
+        for (size_t s = 0; s < n; s += BT_ORDER) {
+            BTLeaf *l = new BTLeaf();
+            for (size_t k = s; k < n && k < s + BT_ORDER; k++) {
+                l->keys[l->n] = keys[k];
+                l->cnt[l->n++] = counts[k];
+                total += counts[k];
+            }
+            l->prev = prev;
+            if (prev) prev->next = l;
+            prev = l;
+            nodes.push_back(l);
+            mins.push_back(keys[s]);
+        }
+        while (nodes.size() > 1) {
+            vector<BTNode *> up;
+            vector<int> upMins;
+            for (size_t s = 0; s < nodes.size(); s += BT_ORDER) {
+                BTInner *in = new BTInner();
+                for (size_t k = s; k < nodes.size() && k < s + BT_ORDER; k++) {
+                    in->child[in->n] = nodes[k];
+                    in->keys[in->n] = in->n ? mins[k] : INT_MIN;
+                    in->cnt[in->n] = sumCounts(nodes[k]);
+                    in->n++;
+                }
+                up.push_back(in);
+                upMins.push_back(mins[s]);
+            }
+            nodes.swap(up);
+            mins.swap(upMins);
+        }
+        root = nodes[0];
+    }
+
+    // Calls f(key, count, level) for every key in order (level is always 0:
+    // no hint).
+    template <class F>
+    void forEachNode(F f) const {
+        BTNode *x = root;
+        while (!x->leaf)
+            x = ((BTInner *)x)->child[0];
+        for (BTLeaf *l = (BTLeaf *)x; l; l = l->next) {
+            for (int i = 0; i < l->n; i++)
+                f(l->keys[i], l->cnt[i], 0);
+        }
+    }
+
+    // --- Insert operation ---
+    void insert(int val) {
+        BTNode *r = insertRec(root, val);
+        total++;
+        if (!r) return;
+        BTInner *nr = new BTInner();
+        int moved = sumCounts(r);
+        int sep = r->keys[0];
+        if (!r->leaf) r->keys[0] = INT_MIN;
+        insertChild(nr, 0, INT_MIN, total - moved, root);
+        insertChild(nr, 1, sep, moved, r);
+        root = nr;
+    }
+
+    // --- Delete All occurrences of a value ---
+    void deleteAll(int val) {
+        total -= eraseRec(root, val);
+        while (!root->leaf && root->n == 1) {
+            BTInner *old = (BTInner *)root;
+            root = old->child[0];
+            delete old;
+        }
+        if (!root->leaf && root->n == 0) {
+            delete (BTInner *)root;
+            root = new BTLeaf();
+        }
+    }
+
+    // --- Search value ---
+    bool search(int val) {
+        return countOccurrence(val) > 0;
     }
 
     // --- Count Occurrence ---
     int countOccurrence(int val) {
-        Node *x = head;
-        for (int i = currLevel - 1; i >= 0; i--) {
-            while (x->next[i] && x->next[i]->val < val)
-                x = x->next[i];
+        int pos;
+        BTLeaf *l = findLeaf(val, pos);
+        return (pos < l->n && l->keys[pos] == val) ? l->cnt[pos] : 0;
+    }
+
+    // --- Lower Bound ---
+    int lowerBound(int val) {
+        int pos;
+        BTLeaf *l = firstAtLeast(val, pos);
+        return l ? l->keys[pos] : 0;
+    }
+
+    // --- Upper Bound ---
+    int upperBound(int val) {
+        if (val == INT_MAX) return 0;
+        return lowerBound(val + 1);
+    }
+
+    // --- Closest Element ---
+    int closestElement(int val) {
+        int pos;
+        BTLeaf *l = findLeaf(val, pos);
+        BTLeaf *pl = l;
+        int pp = pos - 1;
+        while (pl && pp < 0) {
+            pl = pl->prev;
+            if (pl) pp = pl->n - 1;
         }
-        x = x->next[0];
-        int cnt = 0;
-        while (x && x->val == val) {
-            cnt++;
-            x = x->next[0];
+        BTLeaf *sl = l;
+        int sp = pos;
+        while (sl && sp >= sl->n) {
+            sl = sl->next;
+            sp = 0;
         }
-        return cnt;
+
+        if (sl && sl->keys[sp] == val) return val;
+        if (!pl && !sl) return 0;
+        if (!pl) return sl->keys[sp];
+        if (!sl) return pl->keys[pp];
+
+        long long d1 = (long long)val - pl->keys[pp];
+        long long d2 = (long long)sl->keys[sp] - val;
+        return (d1 <= d2 ? pl->keys[pp] : sl->keys[sp]);
+    }
+
+    // --- Rank: number of elements strictly less than val ---
+    int rank(int val) {
+        return countBelow(val, false);
+    }
+
+    // --- Select: k-th smallest element (1-based, 0 if out of range) ---
+    int select(int k) {
+        if (k < 1 || k > total) return 0;
+        BTNode *x = root;
+        for (;;) {
+            Q2_STAT(levels);
+            int i = 0;
+            while (k > x->cnt[i]) {
+                k -= x->cnt[i];
+                i++;
+            }
+            if (x->leaf) return x->keys[i];
+            x = ((BTInner *)x)->child[i];
+        }
+    }
+
+    // --- Count of elements in [lo, hi] ---
+    int countInRange(int lo, int hi) {
+        if (lo > hi) return 0;
+        return countBelow(hi, true) - countBelow(lo, false);
+    }
+
+    // --- Print the base level ---
+    void printBottom(Writer &out) {
+        BTNode *x = root;
+        while (!x->leaf)
+            x = ((BTInner *)x)->child[0];
+        const char *sep = "";
+        for (BTLeaf *l = (BTLeaf *)x; l; l = l->next) {
+            for (int i = 0; i < l->n; i++) {
+                for (int c = 0; c < l->cnt[i]; c++) {
+                    out << sep << l->keys[i];
+                    sep = " ";
+                }
+            }
+        }
+        out << '\n';
+    }
+};
+
+// --- Backend selection ---
+#ifdef Q2_BTREE_BACKEND
+typedef BTreeMultiset OrderedSet;
+#else
+typedef SkipList<int> OrderedSet;
+#endif
+
+// --- Snapshot Files ---
+// Layout, native byte order:
+//   0    char[8]    magic "Q2SNAP01"
+//   8    uint32     sizeof(key)
+//   12   uint32     reserved, 0
+//   16   uint64     n, distinct keys
+//   24   uint64     total elements, counting copies
+//   32   key[n]     strictly increasing
+//   ...  int32[n]   counts, starting at the next multiple of 8
+//   ...  uint8[n]   level hints, 0 = let the loader choose
+// The loader maps the file (mmap where available, fread otherwise) and
+// links nodes straight off the mapped arrays: nothing is parsed or sorted
+// and no random levels are drawn.
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t keySize;
+    uint32_t reserved;
+    uint64_t n;
+    uint64_t total;
+};
+
+static_assert(sizeof(SnapshotHeader) == 32, "snapshot header layout");
+
+const char SNAPSHOT_MAGIC[8] = {'Q', '2', 'S', 'N', 'A', 'P', '0', '1'};
+
+inline size_t snapshotCountsOffset(size_t n, size_t keySize) {
+    return (sizeof(SnapshotHeader) + n * keySize + 7) & ~(size_t)7;
+}
+
+// Read-only view of a whole file.
+class MappedFile {
+    const char *ptr;
+    size_t len;
+    bool mapped;
+    vector<char> copy;
+
+public:
+    MappedFile() {
+        ptr = NULL;
+        len = 0;
+        mapped = false;
+    }
+
+    ~MappedFile() {
+#ifdef Q2_HAVE_MMAP
+        if (mapped) munmap((void *)ptr, len);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const char *path) {
+#ifdef Q2_HAVE_MMAP
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                ptr = (const char *)p;
+                len = st.st_size;
+                mapped = true;
+                close(fd);
+                return true;
+            }
+        }
+        close(fd);
+#endif
+        FILE *f = fopen(path, "rb");
+        if (!f) return false;
+        char buf[1 << 16];
+        size_t k;
+        while ((k = fread(buf, 1, sizeof buf, f)) > 0)
+            copy.insert(copy.end(), buf, buf + k);
+        bool ok = !ferror(f);
+        fclose(f);
+        ptr = copy.data();
+        len = copy.size();
+        return ok;
+    }
+
+    const char *data() const {
+        return ptr;
+    }
+
+    size_t size() const {
+        return len;
+    }
+};
+
+// Writes set to path (through a temporary file renamed into place, so a
+// crash never leaves a half-written snapshot). False on any I/O error.
+template <class Set>
+bool saveSnapshot(const Set &set, const char *path) {
+    typedef typename Set::key_type Key;
+    static_assert(is_trivially_copyable<Key>::value, "snapshot keys must be trivially copyable");
+
+    vector<Key> keys;
+    vector<int32_t> counts;
+    vector<unsigned char> levels;
+    uint64_t total = 0;
+    set.forEachNode([&](const Key &k, int c, int lvl) {
+        keys.push_back(k);
+        counts.push_back(c);
+        levels.push_back((unsigned char)min(lvl, 255));
+        total += c;
+    });
+
+    SnapshotHeader h;
+    memcpy(h.magic, SNAPSHOT_MAGIC, sizeof h.magic);
+    h.keySize = sizeof(Key);
+    h.reserved = 0;
+    h.n = keys.size();
+    h.total = total;
+    size_t n = keys.size();
+    size_t pad = snapshotCountsOffset(n, sizeof(Key)) - sizeof h - n * sizeof(Key);
+    const char zeros[8] = {0};
+
+    string tmp = string(path) + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(&h, sizeof h, 1, f) == 1;
+    ok = ok && fwrite(keys.data(), sizeof(Key), n, f) == n;
+    ok = ok && fwrite(zeros, 1, pad, f) == pad;
+    ok = ok && fwrite(counts.data(), sizeof(int32_t), n, f) == n;
+    ok = ok && fwrite(levels.data(), 1, n, f) == n;
+    ok = (fclose(f) == 0) && ok;
+    ok = ok && rename(tmp.c_str(), path) == 0;
+    if (!ok) remove(tmp.c_str());
+    return ok;
+}
+
+// Replaces the contents of set with the snapshot at path. False (set
+// untouched) if the file is missing, truncated or not a valid snapshot
+// for this key type.
+template <class Set>
+bool loadSnapshot(Set &set, const char *path) {
+    typedef typename Set::key_type Key;
+    static_assert(is_trivially_copyable<Key>::value, "snapshot keys must be trivially copyable");
+
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(SnapshotHeader)) return false;
+    SnapshotHeader h;
+    memcpy(&h, file.data(), sizeof h);
+    if (memcmp(h.magic, SNAPSHOT_MAGIC, sizeof h.magic) != 0 || h.keySize != sizeof(Key)) return false;
+    if (h.n > file.size() / (sizeof(Key) + 5)) return false;
+    size_t n = h.n;
+    size_t countsOff = snapshotCountsOffset(n, sizeof(Key));
+    size_t levelsOff = countsOff + n * sizeof(int32_t);
+    if (file.size() != levelsOff + n) return false;
+
+    const Key *keys = (const Key *)(file.data() + sizeof h);
+    const int32_t *counts = (const int32_t *)(file.data() + countsOff);
+    const unsigned char *levels = (const unsigned char *)(file.data() + levelsOff);
+
+    typename Set::key_compare comp;
+    uint64_t total = 0;
+    for (size_t j = 0; j < n; j++) {
+        if (counts[j] <= 0 || (j && !comp(keys[j - 1], keys[j]))) return false;
+        total += counts[j];
+    }
+    if (total != h.total || total > (uint64_t)INT_MAX) return false;
+
+    set.loadCounted(keys, counts, levels, n);
+    return true;
+}
+
+// --- Epoch-based reclamation ---
+// Lock-free readers may still be standing on a node after it is unlinked,
+// so unlinked nodes are retired rather than freed. Each thread announces
+// the global epoch while inside an EpochGuard; the epoch only advances once
+// every active thread has seen the current one, and a node retired in
+// epoch e is freed once the global epoch reaches e + 2.
+class EpochDomain {
+public:
+    static const int MAX_THREADS = 128;
+
+    static EpochDomain &instance() {
+        static EpochDomain dom;
+        return dom;
+    }
+
+    void enter() {
+        ThreadRecord &r = record();
+        if (r.depth++ == 0) {
+            slots[r.slot].epoch.store(globalEpoch.load());
+            atomic_thread_fence(memory_order_seq_cst);
+        }
+    }
+
+    void exit() {
+        ThreadRecord &r = record();
+        if (--r.depth == 0)
+            slots[r.slot].epoch.store(IDLE, memory_order_release);
+    }
+
+    void retire(void *p) {
+        ThreadRecord &r = record();
+        r.limbo.push_back({globalEpoch.load(), p});
+        if (r.limbo.size() % COLLECT_EVERY == 0)
+            collect(r);
+    }
+
+    ~EpochDomain() {
+        for (Retired &x : orphans)
+            free(x.ptr);
+    }
+
+private:
+    static const unsigned long long IDLE = ~0ULL;
+    static const size_t COLLECT_EVERY = 64;
+
+    struct alignas(64) Slot {
+        atomic<unsigned long long> epoch;
+        atomic<bool> taken;
+    };
+
+    struct Retired {
+        unsigned long long epoch;
+        void *ptr;
+    };
+
+    // Per-thread state; whatever is still in limbo at thread exit goes to
+    // the shared orphan list.
+    struct ThreadRecord {
+        EpochDomain *dom = NULL;
+        int slot = -1;
+        int depth = 0;
+        vector<Retired> limbo;
+
+        ~ThreadRecord() {
+            if (dom) dom->detach(*this);
+        }
+    };
+
+    atomic<unsigned long long> globalEpoch;
+    Slot slots[MAX_THREADS];
+    mutex orphanLock;
+    vector<Retired> orphans;
+
+    EpochDomain() {
+        globalEpoch.store(0);
+        for (int i = 0; i < MAX_THREADS; i++) {
+            slots[i].epoch.store(IDLE);
+            slots[i].taken.store(false);
+        }
+    }
+
+    ThreadRecord &record() {
+        thread_local ThreadRecord rec;
+        if (rec.slot < 0) attach(rec);
+        return rec;
+    }
+
+    void attach(ThreadRecord &rec) {
+        for (int i = 0; i < MAX_THREADS; i++) {
+            bool expected = false;
+            if (slots[i].taken.compare_exchange_strong(expected, true)) {
+                rec.dom = this;
+                rec.slot = i;
+                return;
+            }
+        }
+        throw runtime_error("EpochDomain: too many threads");
+    }
+
+    void detach(ThreadRecord &rec) {
+        slots[rec.slot].epoch.store(IDLE);
+        {
+            lock_guard<mutex> lk(orphanLock);
+            orphans.insert(orphans.end(), rec.limbo.begin(), rec.limbo.end());
+        }
+        rec.limbo.clear();
+        slots[rec.slot].taken.store(false);
+    }
+
+    void tryAdvance() {
+        unsigned long long e = globalEpoch.load();
+        for (int i = 0; i < MAX_THREADS; i++) {
+            unsigned long long s = slots[i].epoch.load();
+            if (s != IDLE && s != e) return;
+        }
+        globalEpoch.compare_exchange_strong(e, e + 1);
+    }
+
+    void collect(ThreadRecord &r) {
+        tryAdvance();
+        unsigned long long e = globalEpoch.load();
+        freeExpired(r.limbo, e);
+        if (orphanLock.try_lock()) {
+            freeExpired(orphans, e);
+            orphanLock.unlock();
+        }
+    }
+
+    static void freeExpired(vector<Retired> &v, unsigned long long e) {
+        size_t k = 0;
+        for (Retired &x : v) {
+            if (x.epoch + 2 <= e) free(x.ptr);
+            else v[k++] = x;
+        }
+        v.resize(k);
+    }
+};
+
+struct EpochGuard {
+    EpochGuard() { EpochDomain::instance().enter(); }
+    ~EpochGuard() { EpochDomain::instance().exit(); }
+};
+
+// --- Concurrent Node ---
+// Forward pointers are atomic words whose low bit marks the node as being
+// removed at that level. count == 0 means logically deleted: a zero count
+// is never incremented again. refs is 2 while the inserter is still linking
+// upper levels (one for the inserter, one for the list), and whichever side
+// drops the last reference retires the node.
+struct CNode {
+    int val;
+    int level;
+    atomic<int> count;
+    atomic<int> refs;
+    atomic<uintptr_t> next[]; // `level` entries
+
+    static CNode *make(int val, int lvl) {
+        CNode *n = (CNode *)malloc(sizeof(CNode) + lvl * sizeof(atomic<uintptr_t>));
+        if (!n) throw bad_alloc();
+        n->val = val;
+        n->level = lvl;
+        new (&n->count) atomic<int>(1);
+        new (&n->refs) atomic<int>(2);
+        for (int i = 0; i < lvl; i++)
+            new (&n->next[i]) atomic<uintptr_t>(0);
+        return n;
+    }
+};
+
+// Per-thread xorshift, so writers never contend on one generator.
+unsigned long long threadRand() {
+    static atomic<unsigned long long> seeds(rng_seed);
+    thread_local unsigned long long s = seeds.fetch_add(0x9E3779B97F4A7C15ULL) | 1;
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+// --- Concurrent SkipList Class ---
+// Lock-free multiset with the same query interface as SkipList, safe to use
+// from any number of threads at once (Herlihy-Shavit style: CAS on forward
+// pointers, marked-pointer removal, searches that help unlink). Readers
+// never write shared memory apart from their epoch slot.
+class ConcurrentSkipList {
+    CNode *head;
+
+    static CNode *ptrOf(uintptr_t w) {
+        return (CNode *)(w & ~(uintptr_t)1);
+    }
+
+    static bool isMarked(uintptr_t w) {
+        return w & 1;
+    }
+
+    // 1 + trailing zero bits of one random word: P = 1/2 per level.
+    static int randomLevel() {
+        unsigned long long r = threadRand();
+        return r ? min(1 + __builtin_ctzll(r), MAX_LEVEL) : MAX_LEVEL;
+    }
+
+    // Fills preds/succs with the unmarked neighbours of val on every level,
+    // unlinking marked nodes on the way. True if succs[0] holds val.
+    bool find(int val, CNode **preds, CNode **succs) {
+    retry:
+        CNode *pred = head;
+        for (int i = MAX_LEVEL - 1; i >= 0; i--) {
+            CNode *curr = ptrOf(pred->next[i].load());
+            while (curr) {
+                uintptr_t succ = curr->next[i].load();
+                if (isMarked(succ)) {
+                    uintptr_t expected = (uintptr_t)curr;
+                    if (!pred->next[i].compare_exchange_strong(expected, succ & ~(uintptr_t)1))
+                        goto retry;
+                    curr = ptrOf(succ);
+                    continue;
+                }
+                if (curr->val >= val) break;
+                pred = curr;
+                curr = ptrOf(succ);
+            }
+            preds[i] = pred;
+            succs[i] = curr;
+        }
+        return succs[0] && succs[0]->val == val;
+    }
+
+    // Marks every level of x top-down; true for the single caller whose
+    // mark on level 0 took effect (that caller finishes the removal).
+    static bool markNode(CNode *x) {
+        for (int i = x->level - 1; i >= 1; i--) {
+            uintptr_t w = x->next[i].load();
+            while (!isMarked(w) && !x->next[i].compare_exchange_weak(w, w | 1)) {}
+        }
+        uintptr_t w = x->next[0].load();
+        while (!isMarked(w)) {
+            if (x->next[0].compare_exchange_weak(w, w | 1)) return true;
+        }
+        return false;
+    }
+
+    static void release(CNode *x) {
+        if (x->refs.fetch_sub(1) == 1)
+            EpochDomain::instance().retire(x);
+    }
+
+    // Finishes removing a node whose count has dropped to zero.
+    void removeNode(CNode *x, CNode **preds, CNode **succs) {
+        if (!markNode(x)) return;
+        find(x->val, preds, succs); // unlinks x on every level
+        release(x);
+    }
+
+    // First live node with value >= val (> val when strict), or NULL.
+    CNode *firstAtLeast(int val, bool strict) {
+        CNode *x = head;
+        for (int i = MAX_LEVEL - 1; i >= 0; i--) {
+            CNode *nx = ptrOf(x->next[i].load(memory_order_acquire));
+            while (nx && (nx->val < val || (strict && nx->val == val))) {
+                x = nx;
+                nx = ptrOf(x->next[i].load(memory_order_acquire));
+            }
+        }
+        CNode *y = ptrOf(x->next[0].load(memory_order_acquire));
+        while (y && y->count.load() == 0)
+            y = ptrOf(y->next[0].load(memory_order_acquire));
+        return y;
+    }
+
+    // Last live node with value < val, or NULL.
+    CNode *lastBelow(int val) {
+        for (;;) {
+            CNode *x = head;
+            for (int i = MAX_LEVEL - 1; i >= 0; i--) {
+                CNode *nx = ptrOf(x->next[i].load(memory_order_acquire));
+                while (nx && nx->val < val) {
+                    x = nx;
+                    nx = ptrOf(x->next[i].load(memory_order_acquire));
+                }
+            }
+            if (x == head) return NULL;
+            if (x->count.load() > 0) return x;
+            val = x->val; // x is dying; look left of it
+        }
+    }
+
+public:
+    ConcurrentSkipList() {
+        head = CNode::make(0, MAX_LEVEL); // val unused: never compared
+    }
+
+    ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+    ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+
+    // Not concurrent with any other operation on this list.
+    ~ConcurrentSkipList() {
+        CNode *x = head;
+        while (x) {
+            CNode *nx = ptrOf(x->next[0].load());
+            free(x);
+            x = nx;
+        }
+    }
+
+    // --- Insert operation ---
+    void insert(int val) {
+        EpochGuard g;
+        CNode *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+        int lvl = randomLevel();
+        CNode *n;
+        for (;;) {
+            if (find(val, preds, succs)) {
+                CNode *x = succs[0];
+                int c = x->count.load();
+                while (c > 0 && !x->count.compare_exchange_weak(c, c + 1)) {}
+                if (c > 0) return;
+                removeNode(x, preds, succs); // dying copy: finish it, then retry
+                continue;
+            }
+            n = CNode::make(val, lvl);
+            for (int i = 0; i < lvl; i++)
+                n->next[i].store((uintptr_t)succs[i], memory_order_relaxed);
+            uintptr_t expected = (uintptr_t)succs[0];
+            if (preds[0]->next[0].compare_exchange_strong(expected, (uintptr_t)n))
+                break;
+            free(n); // never published
+        }
+
+        // n is in the list; link the upper levels unless it is removed first
+        for (int i = 1; i < lvl; i++) {
+            for (;;) {
+                uintptr_t w = n->next[i].load();
+                if (isMarked(w)) goto linked;
+                if (w != (uintptr_t)succs[i] && !n->next[i].compare_exchange_strong(w, (uintptr_t)succs[i]))
+                    goto linked;
+                uintptr_t expected = (uintptr_t)succs[i];
+                if (preds[i]->next[i].compare_exchange_strong(expected, (uintptr_t)n))
+                    break;
+                find(val, preds, succs);
+                if (succs[0] != n) goto linked;
+            }
+        }
+    linked:
+        // a removal that raced with the linking above may have missed levels
+        // linked after its cleanup pass
+        if (isMarked(n->next[0].load()))
+            find(val, preds, succs);
+        release(n);
+    }
+
+    // --- Delete All occurrences of a value ---
+    void deleteAll(int val) {
+        EpochGuard g;
+        CNode *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+        if (!find(val, preds, succs)) return;
+        CNode *x = succs[0];
+        x->count.exchange(0); // later inserts of val cannot revive x
+        removeNode(x, preds, succs);
+    }
+
+    // --- Search value ---
+    bool search(int val) {
+        EpochGuard g;
+        CNode *x = firstAtLeast(val, false);
+        return x && x->val == val;
+    }
+
+    // --- Count Occurrence ---
+    int countOccurrence(int val) {
+        EpochGuard g;
+        CNode *x = firstAtLeast(val, false);
+        return (x && x->val == val) ? x->count.load() : 0;
     }
 
     // --- Lower Bound ---
     int lowerBound(int val) {
-        Node *x = head;
-        for (int i = currLevel - 1; i >= 0; i--) {
-            while (x->next[i] && x->next[i]->val < val)
-                x = x->next[i];
-        }
-        x = x->next[0];
+        EpochGuard g;
+        CNode *x = firstAtLeast(val, false);
         return x ? x->val : 0;
     }
 
     // --- Upper Bound ---
     int upperBound(int val) {
-        Node *x = head;
-        for (int i = currLevel - 1; i >= 0; i--) {
-            while (x->next[i] && x->next[i]->val <= val)
-                x = x->next[i];
-        }
-        x = x->next[0];
+        EpochGuard g;
+        CNode *x = firstAtLeast(val, true);
         return x ? x->val : 0;
     }
 
     // --- Closest Element ---
     int closestElement(int val) {
-        Node *x = head;
-        for (int i = currLevel - 1; i >= 0; i--) {
-            while (x->next[i] && x->next[i]->val < val)
-                x = x->next[i];
-        }
-
-        Node *pred = (x == head ? NULL : x);
-        Node *succ = x->next[0];
-
-        if (succ && succ->val == val) return succ->val;
+        EpochGuard g;
+        CNode *succ = firstAtLeast(val, false);
+        if (succ && succ->val == val) return val;
+        CNode *pred = lastBelow(val);
         if (!pred && !succ) return 0;
         if (!pred) return succ->val;
         if (!succ) return pred->val;
 
         long long d1 = (long long)val - pred->val;
-        if (d1 < 0) d1 = -d1;
         long long d2 = (long long)succ->val - val;
-        if (d2 < 0) d2 = -d2;
         return (d1 <= d2 ? pred->val : succ->val);
     }
 
-    // --- Print the base level of skip list ---
-    void printBottom() {
-        Node *x = head->next[0];
-        if (!x) {
-            cout << "\n";
-            return;
+    // --- Consistency check (no operation may be in flight) ---
+    // Every level is strictly increasing and free of marked or dead nodes,
+    // and every node on level i > 0 is tall enough and also on level i - 1.
+    bool validate() {
+        for (int i = 0; i < MAX_LEVEL; i++) {
+            CNode *below = head; // walks level i - 1 alongside
+            CNode *prev = NULL;
+            for (CNode *x = ptrOf(head->next[i].load()); x; x = ptrOf(x->next[i].load())) {
+                if (x->level <= i || isMarked(x->next[i].load()) || x->count.load() <= 0) return false;
+                if (prev && x->val <= prev->val) return false;
+                if (i > 0) {
+                    while (below && below != x)
+                        below = ptrOf(below->next[i - 1].load());
+                    if (!below) return false;
+                }
+                prev = x;
+            }
         }
-        cout << x->val;
-        x = x->next[0];
-        while (x) {
-            cout << " " << x->val;
-            x = x->next[0];
+        return true;
+    }
+
+    // --- Print the base level (not atomic with respect to writers) ---
+    void printBottom(Writer &out) {
+        EpochGuard g;
+        const char *sep = "";
+        for (CNode *x = ptrOf(head->next[0].load()); x; x = ptrOf(x->next[0].load())) {
+            int c = x->count.load();
+            for (int k = 0; k < c; k++) {
+                out << sep << x->val;
+                sep = " ";
+            }
         }
-        cout << "\n";
+        out << '\n';
     }
 };
 
+// --- Output Modes ---
+// full:    the original format, a blank line first and the whole bottom
+//          level after every operation (O(n) bytes per operation)
+// results: only the answers of queries (choices 3-10)
+// delta:   answers, plus "+ x" for an insert and "- x k" when deleteAll
+//          removed k copies of x
+// In results/delta mode, choice 11 and every --snapshot-every N operations
+// print the bottom level as a line starting with "= ".
+enum OutputMode { OUT_FULL, OUT_RESULTS, OUT_DELTA };
+
 // --- Main Function (as per PDF format) ---
-int main() {
+// Q2_NO_MAIN lets other programs (Q2_bench.cpp) include this file.
+#ifndef Q2_NO_MAIN
+int main(int argc, char **argv) {
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
 
+    OutputMode mode = OUT_FULL;
+    long long snapshotEvery = 0;
+    const char *loadPath = NULL, *savePath = NULL;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        if (a == "--output" && i + 1 < argc) {
+            string m = argv[++i];
+            if (m == "full") mode = OUT_FULL;
+            else if (m == "results") mode = OUT_RESULTS;
+            else if (m == "delta") mode = OUT_DELTA;
+            else {
+                cerr << "unknown output mode: " << m << "\n";
+                return 1;
+            }
+        } else if (a == "--snapshot-every" && i + 1 < argc) {
+            snapshotEvery = atoll(argv[++i]);
+        } else if (a == "--load" && i + 1 < argc) {
+            loadPath = argv[++i];
+        } else if (a == "--save" && i + 1 < argc) {
+            savePath = argv[++i];
+        } else {
+            cerr << "usage: " << argv[0]
+                 << " [--output full|results|delta] [--snapshot-every N] [--load FILE] [--save FILE]\n";
+            return 1;
+        }
+    }
+
+    Writer out(stdout);
     int N;
     cin >> N;
-    SkipList sl;
-    cout <<endl;
-    while (N-- > 0) {
+    OrderedSet sl;
+    if (loadPath && !loadSnapshot(sl, loadPath)) {
+        cerr << "cannot load snapshot: " << loadPath << "\n";
+        return 1;
+    }
+    if (mode == OUT_FULL) out << '\n';
+    for (long long done = 1; N-- > 0; done++) {
         int choice;
         cin >> choice;
 
-
         if (choice == 1) {          // insert
             int x; cin >> x;
             sl.insert(x);
-            sl.printBottom();
-        } 
+            if (mode == OUT_DELTA) out << "+ " << x << '\n';
+        }
         else if (choice == 2) {     // delete
             int x; cin >> x;
+            int removed = (mode == OUT_DELTA) ? sl.countOccurrence(x) : 0;
             sl.deleteAll(x);
-            sl.printBottom();
-        } 
+            if (removed) out << "- " << x << ' ' << removed << '\n';
+        }
         else if (choice == 3) {     // search
             int x; cin >> x;
-            cout << (sl.search(x) ? "true" : "false") << endl;
-            sl.printBottom();
-        } 
+            out << (sl.search(x) ? "true" : "false") << '\n';
+        }
         else if (choice == 4) {     // count occurrences
             int x; cin >> x;
-            cout << sl.countOccurrence(x) << endl;
-            sl.printBottom();
-        } 
+            out << sl.countOccurrence(x) << '\n';
+        }
         else if (choice == 5) {     // lower bound
             int x; cin >> x;
-            cout << sl.lowerBound(x) << endl;
-            sl.printBottom();
-        } 
+            out << sl.lowerBound(x) << '\n';
+        }
         else if (choice == 6) {     // upper bound
             int x; cin >> x;
-            cout << sl.upperBound(x) << endl;
-            sl.printBottom();
-        } 
+            out << sl.upperBound(x) << '\n';
+        }
         else if (choice == 7) {     // closest element
             int x; cin >> x;
-            cout << sl.closestElement(x) << endl;
-            sl.printBottom();
-        } 
+            out << sl.closestElement(x) << '\n';
+        }
+        else if (choice == 8) {     // rank
+            int x; cin >> x;
+            out << sl.rank(x) << '\n';
+        }
+        else if (choice == 9) {     // k-th smallest
+            int k; cin >> k;
+            out << sl.select(k) << '\n';
+        }
+        else if (choice == 10) {    // count in range
+            int lo, hi; cin >> lo >> hi;
+            out << sl.countInRange(lo, hi) << '\n';
+        }
+        else if (choice == 11) {    // snapshot
+            if (mode != OUT_FULL) out << "= ";
+            sl.printBottom(out);
+            continue;
+        }
         else {
             break;
         }
+
+        if (mode == OUT_FULL) {
+            sl.printBottom(out);
+        } else if (snapshotEvery > 0 && done % snapshotEvery == 0) {
+            out << "= ";
+            sl.printBottom(out);
+        }
     }
 
+    if (savePath && !saveSnapshot(sl, savePath)) {
+        cerr << "cannot save snapshot: " << savePath << "\n";
+        return 1;
+    }
     return 0;
 }
+#endif
@@ -0,0 +1,823 @@
+// Operation-mix benchmark for the Q2 ordered-set backends.
+//
+//   g++ -O2 -pthread -o q2_bench Q2_bench.cpp
+//   ./q2_bench [--backend b,b,...] [--dist d,d,...] [--n N,N,...] [--ops M]
+//              [--mix op=w,op=w,...] [--seed S] [--histogram] [--threads T]
+//              [--fill insert|batch|bulk]
+//
+// Backends: skip (P = 1/2, cap growing to MAX_LEVEL, the Q2 default),
+// skip-m16 (P = 1/2, cap stops at 16 levels), skip-p4 (P = 1/4) and btree.
+// Add a row to the backends table below to try other P / MAX_LEVEL values.
+//
+// Distributions: uniform (keys in [0, 4N)), zipf (s = 0.99 over N keys,
+// scattered across the key space), seq (inserts count upwards, queries
+// hit the inserted range) and dup (64 distinct keys).
+//
+// For every backend, distribution and size N, the set is filled with N
+// keys (--fill: one insert each, the default; one insertBatch; or one
+// bulkLoad), then the same M-operation stream (default 10^6; weights from
+// --mix) runs twice on fresh copies: once untimed per operation for
+// throughput, once timing every call for the p50/p99/p999 latencies.
+// Levels/op is the number of skip-list levels (or B+-tree nodes) each
+// descent visits, steps/op the forward links it follows. Bytes/elem is the
+// heap held by the filled set per element. A checksum of all answers must
+// agree across backends, otherwise the row is marked FAIL.
+//
+// --threads T adds a "concurrent" row per table: T threads fill a shared
+// ConcurrentSkipList with single inserts (whatever --fill says), then run
+// their share of the operation stream on it (rank, select and range are
+// skipped; that list has no spans). It is marked FAIL unless every count
+// after the fill is exact, every key the stream never deletes ends with
+// exactly its inserted count, all answers are plausible for some
+// interleaving, and validate() passes once the threads have joined.
+//
+// After the tables, a fixed check runs SkipList<int, greater<int>>,
+// SkipList<long long> and the map-style SkipList<string, int> (operator[]
+// and find) against std::multiset / std::map; any mismatch is a FAIL row.
+#define Q2_NO_MAIN
+#define Q2_STATS
+#include "Q2.cpp"
+#undef Q2_NO_MAIN
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+using namespace std;
+
+// --- Heap accounting ---
+// Every block carries its size in a 16-byte header so frees can be
+// subtracted and liveBytes is exact. Atomic because --threads allocates
+// from several threads.
+atomic<long long> liveBytes(0);
+
+void *operator new(size_t n) {
+    char *p = (char *)malloc(n + 16);
+    if (!p) throw bad_alloc();
+    *(size_t *)p = n;
+    liveBytes.fetch_add(n, memory_order_relaxed);
+    return p + 16;
+}
+
+// noinline keeps GCC from pairing the inlined free() with operator new
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    if (!p) return;
+    char *b = (char *)p - 16;
+    liveBytes.fetch_sub(*(size_t *)b, memory_order_relaxed);
+    free(b);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept {
+    operator delete(p);
+}
+
+// Over-aligned types (the B+-tree nodes): the header sits just before the
+// block, inside one alignment unit of padding.
+void *operator new(size_t n, align_val_t al) {
+    size_t a = max((size_t)al, (size_t)16);
+    char *p = (char *)aligned_alloc(a, (n + 2 * a - 1) / a * a);
+    if (!p) throw bad_alloc();
+    *(size_t *)(p + a - 16) = n;
+    liveBytes.fetch_add(n, memory_order_relaxed);
+    return p + a;
+}
+
+__attribute__((noinline)) void operator delete(void *p, align_val_t al) noexcept {
+    if (!p) return;
+    size_t a = max((size_t)al, (size_t)16);
+    liveBytes.fetch_sub(*(size_t *)((char *)p - 16), memory_order_relaxed);
+    free((char *)p - a);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t, align_val_t al) noexcept {
+    operator delete(p, al);
+}
+
+// --- Operations ---
+enum OpKind { OP_INSERT, OP_DELETE, OP_SEARCH, OP_COUNT, OP_LOWER, OP_UPPER, OP_CLOSEST, OP_RANK, OP_SELECT, OP_RANGE, OP_KINDS };
+
+const char *OP_NAMES[OP_KINDS] = {"insert", "delete", "search", "count", "lower", "upper", "closest", "rank", "select", "range"};
+
+struct Op {
+    unsigned char kind;
+    int a, b;
+};
+
+// --- Workloads ---
+// Keys for the fill and for the operation stream. Query keys come from
+// the same distribution as inserts, except for seq, whose queries hit the
+// range inserted so far.
+class Workload {
+    string dist;
+    int n;
+    unsigned long long state;
+    int seqNext;
+    vector<double> zipfCdf;
+
+    unsigned long long rand64() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    double uniform01() {
+        return (rand64() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Zipf rank in [0, n), by binary search over the cumulative weights.
+    int zipfRank() {
+        double u = uniform01() * zipfCdf.back();
+        return lower_bound(zipfCdf.begin(), zipfCdf.end(), u) - zipfCdf.begin();
+    }
+
+    // Spreads Zipf ranks over the key space so hot keys are not adjacent.
+    static int scatter(int r) {
+        return (int)(((unsigned)r * 2654435761u) & 0x3fffffff);
+    }
+
+public:
+    Workload(const string &d, int size, unsigned long long seed) : dist(d), n(max(size, 1)) {
+        state = seed * 0x9e3779b97f4a7c15ULL + 1;
+        seqNext = 0;
+        if (dist == "zipf") {
+            zipfCdf.resize(n);
+            double sum = 0;
+            for (int i = 0; i < n; i++) {
+                sum += 1.0 / pow(i + 1.0, 0.99);
+                zipfCdf[i] = sum;
+            }
+        }
+    }
+
+    static bool known(const string &d) {
+        return d == "uniform" || d == "zipf" || d == "seq" || d == "dup";
+    }
+
+    int insertKey() {
+        if (dist == "seq") return seqNext++;
+        return queryKey();
+    }
+
+    int queryKey() {
+        if (dist == "zipf") return scatter(zipfRank());
+        if (dist == "dup") return rand64() % 64;
+        if (dist == "seq") return seqNext ? rand64() % seqNext : 0;
+        return rand64() % (4ULL * n);
+    }
+
+    int below(int m) {
+        return rand64() % m;
+    }
+
+    vector<Op> stream(int ops, const int *weights) {
+        int sum = 0;
+        for (int k = 0; k < OP_KINDS; k++)
+            sum += weights[k];
+        vector<Op> v(ops);
+        for (Op &op : v) {
+            int w = below(sum), k = 0;
+            while (w >= weights[k])
+                w -= weights[k++];
+            op.kind = k;
+            op.a = k == OP_INSERT ? insertKey() : k == OP_SELECT ? 1 + below(n) : queryKey();
+            op.b = 0;
+            if (k == OP_RANGE) {
+                op.b = queryKey();
+                if (op.b < op.a) swap(op.a, op.b);
+            }
+        }
+        return v;
+    }
+};
+
+// --- Running a stream ---
+template <class Set>
+long long apply(Set &s, const Op &op) {
+    switch (op.kind) {
+    case OP_INSERT: s.insert(op.a); return 0;
+    case OP_DELETE: s.deleteAll(op.a); return 0;
+    case OP_SEARCH: return s.search(op.a);
+    case OP_COUNT: return s.countOccurrence(op.a);
+    case OP_LOWER: return s.lowerBound(op.a);
+    case OP_UPPER: return s.upperBound(op.a);
+    case OP_CLOSEST: return s.closestElement(op.a);
+    case OP_RANK: return s.rank(op.a);
+    case OP_SELECT: return s.select(op.a);
+    default: return s.countInRange(op.a, op.b);
+    }
+}
+
+struct Result {
+    double buildNs;      // per insert of the fill
+    double bytesPerElem; // < 0 when not measured
+    bool counted;        // levels/steps are meaningful
+    double opsPerSec;
+    long long checksum;
+    vector<unsigned> lat[OP_KINDS]; // ns per timed call
+    unsigned long long levels[OP_KINDS], steps[OP_KINDS];
+};
+
+double nsSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+}
+
+enum FillMode { FILL_INSERT, FILL_BATCH, FILL_BULK };
+const char *const FILL_NAMES[] = {"insert", "batch", "bulk"};
+
+template <class Set>
+void fillSet(Set &s, const vector<int> &fill, FillMode mode) {
+    if (mode == FILL_BATCH) {
+        s.insertBatch(fill);
+    } else if (mode == FILL_BULK) {
+        s.bulkLoad(fill);
+    } else {
+        for (int x : fill)
+            s.insert(x);
+    }
+}
+
+template <class Set>
+Result runBackend(const vector<int> &fill, const vector<Op> &ops, FillMode mode) {
+    Result r;
+    r.checksum = 0;
+    r.counted = true;
+    memset(r.levels, 0, sizeof r.levels);
+    memset(r.steps, 0, sizeof r.steps);
+
+    // throughput pass; also measures the fill
+    {
+        rng_seed = 88172645463325252ULL;
+        long long before = liveBytes;
+        auto t0 = chrono::steady_clock::now();
+        Set *s = new Set();
+        fillSet(*s, fill, mode);
+        r.buildNs = fill.empty() ? 0 : nsSince(t0) / fill.size();
+        r.bytesPerElem = fill.empty() ? 0 : double(liveBytes - before) / fill.size();
+
+        t0 = chrono::steady_clock::now();
+        for (const Op &op : ops)
+            r.checksum += apply(*s, op);
+        double ns = nsSince(t0);
+        r.opsPerSec = ns > 0 ? ops.size() * 1e9 / ns : 0;
+        delete s;
+    }
+
+    // latency pass, on an identical copy
+    {
+        rng_seed = 88172645463325252ULL;
+        Set *s = new Set();
+        fillSet(*s, fill, mode);
+        for (int k = 0; k < OP_KINDS; k++)
+            r.lat[k].reserve(ops.size() / 4);
+        for (const Op &op : ops) {
+            SearchStats st = searchStats;
+            auto t0 = chrono::steady_clock::now();
+            apply(*s, op);
+            r.lat[op.kind].push_back((unsigned)min(nsSince(t0), 4e9));
+            r.levels[op.kind] += searchStats.levels - st.levels;
+            r.steps[op.kind] += searchStats.steps - st.steps;
+        }
+        delete s;
+    }
+    return r;
+}
+
+// --- Concurrent run ---
+// Op kinds the lock-free list supports: it keeps no spans, so no rank,
+// select or range.
+bool concurrentOp(int kind) {
+    return kind != OP_RANK && kind != OP_SELECT && kind != OP_RANGE;
+}
+
+long long applyConcurrent(ConcurrentSkipList &s, const Op &op) {
+    switch (op.kind) {
+    case OP_INSERT: s.insert(op.a); return 0;
+    case OP_DELETE: s.deleteAll(op.a); return 0;
+    case OP_SEARCH: return s.search(op.a);
+    case OP_COUNT: return s.countOccurrence(op.a);
+    case OP_LOWER: return s.lowerBound(op.a);
+    case OP_UPPER: return s.upperBound(op.a);
+    default: return s.closestElement(op.a);
+    }
+}
+
+// Answer check that holds under any interleaving: the list never reports
+// a key on the wrong side of the query (0 means none; workload keys are
+// non-negative).
+bool plausible(const Op &op, long long ans) {
+    switch (op.kind) {
+    case OP_COUNT: return ans >= 0;
+    case OP_LOWER: return ans == 0 || ans >= op.a;
+    case OP_UPPER: return ans == 0 || ans > op.a;
+    default: return true;
+    }
+}
+
+Result runConcurrent(const vector<int> &fill, const vector<Op> &ops, int threads, int &bad) {
+    Result r;
+    r.checksum = 0;
+    r.counted = false;
+    r.bytesPerElem = -1; // nodes come from malloc, not operator new
+    memset(r.levels, 0, sizeof r.levels);
+    memset(r.steps, 0, sizeof r.steps);
+    bad = 0;
+
+    ConcurrentSkipList list;
+    vector<thread> pool;
+    auto t0 = chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            for (size_t j = t; j < fill.size(); j += threads)
+                list.insert(fill[j]);
+        });
+    }
+    for (thread &th : pool)
+        th.join();
+    pool.clear();
+    r.buildNs = fill.empty() ? 0 : nsSince(t0) / fill.size();
+
+    // exact counts after the concurrent fill
+    map<int, long long> expected;
+    for (int x : fill)
+        expected[x]++;
+    for (auto &e : expected) {
+        if (list.countOccurrence(e.first) != e.second) bad++;
+    }
+
+    vector<vector<unsigned>> lat((size_t)threads * OP_KINDS);
+    vector<int> wrong(threads, 0);
+    size_t chunk = (ops.size() + threads - 1) / max(threads, 1);
+    t0 = chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            size_t end = min(ops.size(), (t + 1) * chunk);
+            for (size_t j = t * chunk; j < end; j++) {
+                const Op &op = ops[j];
+                if (!concurrentOp(op.kind)) continue;
+                auto s0 = chrono::steady_clock::now();
+                long long ans = applyConcurrent(list, op);
+                lat[(size_t)t * OP_KINDS + op.kind].push_back((unsigned)min(nsSince(s0), 4e9));
+                if (!plausible(op, ans)) wrong[t]++;
+            }
+        });
+    }
+    for (thread &th : pool)
+        th.join();
+    double ns = nsSince(t0);
+    size_t done = 0;
+    for (int t = 0; t < threads; t++) {
+        bad += wrong[t];
+        for (int k = 0; k < OP_KINDS; k++) {
+            vector<unsigned> &v = lat[(size_t)t * OP_KINDS + k];
+            r.lat[k].insert(r.lat[k].end(), v.begin(), v.end());
+            done += v.size();
+        }
+    }
+    r.opsPerSec = ns > 0 ? done * 1e9 / ns : 0;
+
+    // quiescent: keys the stream never deletes must hold exactly their
+    // inserted count, the others at most that
+    map<int, bool> deleted;
+    for (const Op &op : ops) {
+        if (op.kind == OP_INSERT) expected[op.a]++;
+        if (op.kind == OP_DELETE) deleted[op.a] = true;
+    }
+    for (auto &e : expected) {
+        int c = list.countOccurrence(e.first);
+        if (deleted.count(e.first) ? c > e.second : c != e.second) bad++;
+    }
+    if (!list.validate()) bad++;
+    return r;
+}
+
+struct Backend {
+    const char *name;
+    Result (*run)(const vector<int> &, const vector<Op> &, FillMode);
+};
+
+const Backend BACKENDS[] = {
+    {"skip", runBackend<SkipList<int>>},
+    {"skip-m16", runBackend<SkipList<int, NoValue, less<int>, allocator<int>, 16, 1, 2>>},
+    {"skip-p4", runBackend<SkipList<int, NoValue, less<int>, allocator<int>, MAX_LEVEL, 1, 4>>},
+    {"btree", runBackend<BTreeMultiset>},
+};
+
+// --- Instantiation checks ---
+// The tables above only run SkipList<int>. These drive the other shapes
+// the template promises (a reversed comparator, 64-bit keys, a map with
+// string keys) through every operation and compare each answer with the
+// std container. Rank and select on the std side walk the tree, so the
+// sizes stay small.
+const int CHECK_N = 2000, CHECK_OPS = 20000;
+
+// std::multiset behind the SkipList query interface.
+template <class Key, class Compare = less<Key>>
+struct StdMultiset {
+    multiset<Key, Compare> s;
+
+    int size() const {
+        return s.size();
+    }
+
+    void insert(const Key &k) {
+        s.insert(k);
+    }
+
+    void deleteAll(const Key &k) {
+        s.erase(k);
+    }
+
+    bool search(const Key &k) const {
+        return s.count(k) > 0;
+    }
+
+    int countOccurrence(const Key &k) const {
+        return s.count(k);
+    }
+
+    Key lowerBound(const Key &k) const {
+        auto it = s.lower_bound(k);
+        return it == s.end() ? Key() : *it;
+    }
+
+    Key upperBound(const Key &k) const {
+        auto it = s.upper_bound(k);
+        return it == s.end() ? Key() : *it;
+    }
+
+    Key closestElement(const Key &k) const {
+        auto succ = s.lower_bound(k);
+        if (succ != s.end() && !s.key_comp()(k, *succ)) return *succ;
+        if (succ == s.begin()) return succ == s.end() ? Key() : *succ;
+        auto pred = prev(succ);
+        if (succ == s.end()) return *pred;
+        return keyDistance(*pred, k) <= keyDistance(k, *succ) ? *pred : *succ;
+    }
+
+    int rank(const Key &k) const {
+        return distance(s.begin(), s.lower_bound(k));
+    }
+
+    Key select(int k) const {
+        if (k < 1 || k > size()) return Key();
+        return *next(s.begin(), k - 1);
+    }
+
+    int countInRange(const Key &lo, const Key &hi) const {
+        if (s.key_comp()(hi, lo)) return 0;
+        return distance(s.lower_bound(lo), s.upper_bound(hi));
+    }
+};
+
+// std::map behind the map-style SkipList interface.
+struct StdMap {
+    map<string, int> m;
+
+    int size() const {
+        return m.size();
+    }
+
+    int &operator[](const string &k) {
+        return m[k];
+    }
+
+    int *find(const string &k) {
+        auto it = m.find(k);
+        return it == m.end() ? NULL : &it->second;
+    }
+
+    void deleteAll(const string &k) {
+        m.erase(k);
+    }
+
+    int countOccurrence(const string &k) const {
+        return m.count(k);
+    }
+
+    string lowerBound(const string &k) const {
+        auto it = m.lower_bound(k);
+        return it == m.end() ? string() : it->first;
+    }
+
+    string upperBound(const string &k) const {
+        auto it = m.upper_bound(k);
+        return it == m.end() ? string() : it->first;
+    }
+
+    int rank(const string &k) const {
+        return distance(m.begin(), m.lower_bound(k));
+    }
+
+    string select(int k) const {
+        if (k < 1 || k > size()) return string();
+        return next(m.begin(), k - 1)->first;
+    }
+
+    int countInRange(const string &lo, const string &hi) const {
+        if (hi < lo) return 0;
+        return distance(m.lower_bound(lo), m.upper_bound(hi));
+    }
+};
+
+// Runs the stream with keys mapped through key(); select keeps its rank.
+// Both argument orders go to countInRange, so whichever order Compare
+// calls empty is covered too.
+template <class Set, class Key>
+long long applyKeyed(Set &s, const Op &op, Key (*key)(int)) {
+    switch (op.kind) {
+    case OP_INSERT: s.insert(key(op.a)); return 0;
+    case OP_DELETE: s.deleteAll(key(op.a)); return 0;
+    case OP_SEARCH: return s.search(key(op.a));
+    case OP_COUNT: return s.countOccurrence(key(op.a));
+    case OP_LOWER: return s.lowerBound(key(op.a));
+    case OP_UPPER: return s.upperBound(key(op.a));
+    case OP_CLOSEST: return s.closestElement(key(op.a));
+    case OP_RANK: return s.rank(key(op.a));
+    case OP_SELECT: return s.select(op.a);
+    default: return s.countInRange(key(op.a), key(op.b)) + 1000003LL * s.countInRange(key(op.b), key(op.a));
+    }
+}
+
+string mapKey(int x) {
+    return "k" + to_string(x); // lexicographic, so not the numeric order
+}
+
+long long mapKeyId(const string &k) {
+    return k.empty() ? -1 : atoll(k.c_str() + 1);
+}
+
+// Map-style stream: insert bumps the payload through operator[], search
+// reads it back through find.
+template <class Map>
+long long applyMap(Map &m, const Op &op) {
+    string k = mapKey(op.a);
+    switch (op.kind) {
+    case OP_INSERT: return m[k] += op.a % 7 + 1;
+    case OP_DELETE: m.deleteAll(k); return 0;
+    case OP_SEARCH:
+    case OP_CLOSEST: {
+        int *v = m.find(k);
+        return v ? *v : -1;
+    }
+    case OP_COUNT: return m.countOccurrence(k);
+    case OP_LOWER: return mapKeyId(m.lowerBound(k));
+    case OP_UPPER: return mapKeyId(m.upperBound(k));
+    case OP_RANK: return m.rank(k);
+    case OP_SELECT: return mapKeyId(m.select(op.a));
+    default: return m.countInRange(k, mapKey(op.b)) + 1000003LL * m.countInRange(mapKey(op.b), k);
+    }
+}
+
+// Answers that differ between the two containers, over the stream and a
+// final select of every position.
+template <class Set, class Ref, class Apply>
+int countMismatches(const vector<Op> &ops, Apply apply) {
+    Set s;
+    Ref r;
+    int bad = 0;
+    for (const Op &op : ops)
+        if (apply(s, op) != apply(r, op)) bad++;
+    if (s.size() != r.size()) bad++;
+    for (int i = 1; i <= r.size(); i++) {
+        Op sel = {OP_SELECT, i, 0};
+        if (apply(s, sel) != apply(r, sel)) bad++;
+    }
+    return bad;
+}
+
+int identityKey(int x) {
+    return x;
+}
+
+// Alternately near LLONG_MIN and LLONG_MAX, so closest spans the full range.
+long long wideKey(int x) {
+    long long off = (long long)(x >> 1) << 32;
+    return x & 1 ? LLONG_MAX - off : LLONG_MIN + off;
+}
+
+// One row per instantiation; returns the number of failed rows.
+int runInstantiationChecks(unsigned long long seed) {
+    Workload w("uniform", CHECK_N, seed);
+    int weights[OP_KINDS] = {30, 10, 10, 5, 10, 10, 10, 5, 5, 5};
+    vector<Op> ops(CHECK_N);
+    for (Op &op : ops)
+        op = {OP_INSERT, w.insertKey(), 0};
+    vector<Op> stream = w.stream(CHECK_OPS, weights);
+    ops.insert(ops.end(), stream.begin(), stream.end());
+
+    struct Row {
+        const char *name, *ref;
+        int bad;
+    } rows[] = {
+        {"SkipList<int, greater>", "multiset<int, greater>",
+         countMismatches<SkipList<int, NoValue, greater<int>>, StdMultiset<int, greater<int>>>(
+             ops, [](auto &s, const Op &op) { return applyKeyed(s, op, identityKey); })},
+        {"SkipList<long long>", "multiset<long long>",
+         countMismatches<SkipList<long long>, StdMultiset<long long>>(
+             ops, [](auto &s, const Op &op) { return applyKeyed(s, op, wideKey); })},
+        {"SkipList<string, int>", "map<string, int>",
+         countMismatches<SkipList<string, int>, StdMap>(ops, [](auto &s, const Op &op) { return applyMap(s, op); })},
+    };
+
+    printf("== instantiation checks, n %d, ops %d\n", CHECK_N, CHECK_OPS);
+    printf("%-24s %-24s %9s %8s\n", "backend", "against", "mismatch", "check");
+    int failures = 0;
+    for (const Row &r : rows) {
+        printf("%-24s %-24s %9d %8s\n", r.name, r.ref, r.bad, r.bad ? "FAIL" : "ok");
+        if (r.bad) failures++;
+    }
+    printf("\n");
+    return failures;
+}
+
+// --- Reporting ---
+unsigned percentile(const vector<unsigned> &sorted, double q) {
+    if (sorted.empty()) return 0;
+    size_t i = (size_t)(q * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+// Power-of-two latency buckets: "<=2^k ns  count".
+void printHistogram(const vector<unsigned> &sorted) {
+    size_t i = 0;
+    for (int b = 0; i < sorted.size(); b++) {
+        unsigned long long hi = 1ULL << b;
+        size_t c = 0;
+        while (i < sorted.size() && sorted[i] <= hi) {
+            i++;
+            c++;
+        }
+        if (c) printf("      <= %10llu ns %10zu  %5.1f%%\n", hi, c, 100.0 * c / sorted.size());
+    }
+}
+
+void printRows(const char *name, Result &r, const char *check, bool histogram) {
+    bool first = true;
+    for (int k = 0; k < OP_KINDS; k++) {
+        vector<unsigned> &v = r.lat[k];
+        if (v.empty()) continue;
+        sort(v.begin(), v.end());
+        if (first) {
+            printf("%-10s %8.0f", name, r.buildNs);
+            if (r.bytesPerElem < 0)
+                printf(" %7s", "-");
+            else
+                printf(" %7.1f", r.bytesPerElem);
+            printf(" %8.2f %8s", r.opsPerSec / 1e6, check);
+        } else {
+            printf("%-10s %8s %7s %8s %8s", "", "", "", "", "");
+        }
+        first = false;
+        printf("  %-8s %8zu", OP_NAMES[k], v.size());
+        if (r.counted)
+            printf(" %6.1f %6.1f", double(r.levels[k]) / v.size(), double(r.steps[k]) / v.size());
+        else
+            printf(" %6s %6s", "-", "-");
+        printf(" %7u %7u %7u\n", percentile(v, 0.50), percentile(v, 0.99), percentile(v, 0.999));
+        if (histogram) printHistogram(v);
+    }
+    fflush(stdout);
+}
+
+vector<string> splitList(const string &list) {
+    vector<string> v;
+    for (size_t p = 0; p <= list.size();) {
+        size_t q = list.find(',', p);
+        if (q == string::npos) q = list.size();
+        if (q > p) v.push_back(list.substr(p, q - p));
+        p = q + 1;
+    }
+    return v;
+}
+
+int usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [--backend b,...] [--dist d,...] [--n N,...] [--ops M] [--mix op=w,...] "
+            "[--seed S] [--histogram] [--threads T] [--fill insert|batch|bulk]\n",
+            prog);
+    return 1;
+}
+
+// --- Driver ---
+int main(int argc, char **argv) {
+    vector<string> backends, dists = {"uniform", "zipf", "seq", "dup"};
+    for (const Backend &b : BACKENDS)
+        backends.push_back(b.name);
+    vector<int> sizes = {100000};
+    int numOps = 1000000;
+    unsigned long long seed = 1;
+    bool histogram = false;
+    int threads = 0;
+    FillMode fillMode = FILL_INSERT;
+    int weights[OP_KINDS] = {30, 5, 20, 0, 15, 10, 20, 0, 0, 0};
+
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        bool hasArg = i + 1 < argc;
+        if (a == "--histogram") {
+            histogram = true;
+        } else if (a == "--backend" && hasArg) {
+            backends = splitList(argv[++i]);
+        } else if (a == "--dist" && hasArg) {
+            dists = splitList(argv[++i]);
+        } else if (a == "--n" && hasArg) {
+            sizes.clear();
+            for (const string &s : splitList(argv[++i]))
+                sizes.push_back(atoi(s.c_str()));
+        } else if (a == "--ops" && hasArg) {
+            numOps = atoi(argv[++i]);
+        } else if (a == "--fill" && hasArg) {
+            string m = argv[++i];
+            if (m == "insert") {
+                fillMode = FILL_INSERT;
+            } else if (m == "batch") {
+                fillMode = FILL_BATCH;
+            } else if (m == "bulk") {
+                fillMode = FILL_BULK;
+            } else {
+                fprintf(stderr, "unknown fill mode: %s\n", m.c_str());
+                return 1;
+            }
+        } else if (a == "--threads" && hasArg) {
+            threads = atoi(argv[++i]);
+        } else if (a == "--seed" && hasArg) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (a == "--mix" && hasArg) {
+            memset(weights, 0, sizeof weights);
+            for (const string &item : splitList(argv[++i])) {
+                size_t eq = item.find('=');
+                int k = 0;
+                while (k < OP_KINDS && item.substr(0, eq) != OP_NAMES[k])
+                    k++;
+                if (eq == string::npos || k == OP_KINDS) {
+                    fprintf(stderr, "unknown mix entry: %s\n", item.c_str());
+                    return 1;
+                }
+                weights[k] = atoi(item.c_str() + eq + 1);
+            }
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    int weightSum = 0;
+    for (int k = 0; k < OP_KINDS; k++)
+        weightSum += max(weights[k], 0);
+    if (weightSum == 0 || numOps < 0 || threads < 0) return usage(argv[0]);
+    vector<const Backend *> chosen;
+    for (const string &name : backends) {
+        const Backend *found = NULL;
+        for (const Backend &b : BACKENDS)
+            if (name == b.name) found = &b;
+        if (!found) {
+            fprintf(stderr, "unknown backend: %s\n", name.c_str());
+            return 1;
+        }
+        chosen.push_back(found);
+    }
+    for (const string &d : dists) {
+        if (!Workload::known(d)) {
+            fprintf(stderr, "unknown distribution: %s\n", d.c_str());
+            return 1;
+        }
+    }
+
+    int failures = 0;
+    for (const string &dist : dists) {
+        for (int n : sizes) {
+            Workload w(dist, n, seed);
+            vector<int> fill(max(n, 0));
+            for (int &x : fill)
+                x = w.insertKey();
+            vector<Op> ops = w.stream(numOps, weights);
+
+            printf("== dist %s, n %d, ops %d, fill %s\n", dist.c_str(), n, numOps, FILL_NAMES[fillMode]);
+            printf("%-10s %8s %7s %8s %8s  %-8s %8s %6s %6s %7s %7s %7s\n", "backend", "fill ns", "B/elem",
+                   "Mops/s", "check", "op", "calls", "lvl", "steps", "p50", "p99", "p999");
+            long long expected = 0;
+            for (size_t bi = 0; bi < chosen.size(); bi++) {
+                Result r = chosen[bi]->run(fill, ops, fillMode);
+                if (bi == 0) expected = r.checksum;
+                bool ok = r.checksum == expected;
+                if (!ok) failures++;
+                printRows(chosen[bi]->name, r, ok ? "ok" : "FAIL", histogram);
+            }
+            if (threads > 0) {
+                int bad;
+                Result r = runConcurrent(fill, ops, threads, bad);
+                if (bad) failures++;
+                printRows("concurrent", r, bad ? "FAIL" : "ok", histogram);
+                if (bad) printf("concurrent: %d check(s) failed with %d threads\n", bad, threads);
+            }
+            printf("\n");
+        }
+    }
+
+    failures += runInstantiationChecks(seed);
+    if (failures) printf("%d failed table row(s)\n", failures);
+    return failures ? 1 : 0;
+}